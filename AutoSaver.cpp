@@ -0,0 +1,61 @@
+#include "AutoSaver.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSaveFile>
+#include "Trace.h"
+#include "utilities.h"
+
+AutoSaver::AutoSaver() {
+    writer.setMaxThreadCount(1);
+    timer.setInterval(defaultInterval);
+    QObject::connect(&timer, &QTimer::timeout, [this] { saveNow(); });
+    timer.start();
+}
+
+AutoSaver::~AutoSaver() {
+    writer.waitForDone();
+}
+
+void AutoSaver::markClean() {
+    modified = pending = false;
+    if (path.isEmpty()) return;
+    // Queued behind any write still in flight, which would otherwise bring the file back.
+    writer.start([path = path] { QFile::remove(path); });
+}
+
+void AutoSaver::saveNow() {
+    if (!pending || path.isEmpty() || !snapshotSource) return;
+    TRACE_SCOPE("AutoSaver::snapshot");
+    QElapsedTimer elapsed;
+    elapsed.start();
+    Snapshot snapshot = snapshotSource();
+    lastSnapshot = elapsed.nsecsElapsed();
+    maxSnapshot = std::max(maxSnapshot, lastSnapshot);
+    pending = false;
+
+    writer.start([path = path, snapshot = std::move(snapshot)] {
+        TRACE_SCOPE("AutoSaver::write");
+        QByteArray encoded;
+        encrypt(snapshot.tiles.rows(), snapshot.tiles.columns(), snapshot.tiles.toVector(), snapshot.nextLevel, encoded);
+        std::string record;
+        rle::appendPackRecord(snapshot.number, std::string_view(encoded.constData(), encoded.size()), record);
+        QSaveFile output(path);
+        if (!output.open(QIODevice::WriteOnly) || output.write(record.data(), static_cast<qint64>(record.size())) != static_cast<qint64>(record.size())
+            || !output.commit())
+            qWarning() << "Unable to autosave to" << path << output.errorString();
+    });
+}
+
+bool AutoSaver::readRecovery(const QString& path, int& number, rle::Level& level) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    const QByteArray content = file.readAll();
+    const std::string_view view(content.constData(), content.size());
+    const std::vector<rle::PackRecord> records = rle::scanPack(view);
+    if (records.empty()) return false;
+    std::string scratch;
+    number = records.front().number;
+    return !rle::decode(rle::recordText(view.substr(records.front().offset, records.front().length), scratch), level);
+}
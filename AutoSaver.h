@@ -0,0 +1,60 @@
+#ifndef AUTOSAVER_H
+#define AUTOSAVER_H
+
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+#include <functional>
+#include "RleCodec.h"
+#include "TileMap.h"
+
+// Periodically writes the level being edited to a recovery file, a one-level .rll
+// pack, so a crash loses at most one interval of work. On the GUI thread an
+// autosave only takes a copy-on-write snapshot of the tiles, and that is timed;
+// encoding and the atomic write run on a background thread.
+class AutoSaver
+{
+public:
+    static constexpr int defaultInterval = 30 * 1000;
+
+    struct Snapshot {
+        int number = 0;
+        TileMap tiles;
+        int nextLevel[4] = {0, 0, 0, 0};
+    };
+
+    AutoSaver();
+    ~AutoSaver();
+    AutoSaver(const AutoSaver&) = delete;
+    AutoSaver& operator=(const AutoSaver&) = delete;
+
+    void setPath(const QString& recoveryPath) { path = recoveryPath; }
+    void setInterval(int milliseconds) { timer.setInterval(milliseconds); }
+    void setSnapshotSource(std::function<Snapshot()> source) { snapshotSource = std::move(source); }
+
+    // Edited since the last save or discard; an autosave does not change this.
+    bool isDirty() const { return modified; }
+    void markDirty() { modified = pending = true; }
+    // The edits are saved or thrown away, so the recovery file goes too.
+    void markClean();
+    void saveNow();
+
+    qint64 lastSnapshotNanoseconds() const { return lastSnapshot; }
+    qint64 maxSnapshotNanoseconds() const { return maxSnapshot; }
+
+    // Reads a recovery file; number is the level it belongs to, 0 for a level never saved.
+    static bool readRecovery(const QString& path, int& number, rle::Level& level);
+
+private:
+    QString path;
+    QTimer timer;
+    QThreadPool writer;
+    std::function<Snapshot()> snapshotSource;
+    bool modified = false;
+    // Edited since the last autosave.
+    bool pending = false;
+    qint64 lastSnapshot = 0;
+    qint64 maxSnapshot = 0;
+};
+
+#endif // AUTOSAVER_H
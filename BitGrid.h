@@ -0,0 +1,48 @@
+#ifndef BITGRID_H
+#define BITGRID_H
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <vector>
+
+// One bit per cell, each row padded to whole 64-bit words so rows can be combined
+// and shifted a word at a time. Padding bits are always zero.
+class BitGrid
+{
+public:
+    BitGrid() = default;
+    BitGrid(int rows, int columns)
+    : rowCount(rows), columnCount(columns), stride((columns + 63) / 64), bits(static_cast<size_t>(rows) * stride) {}
+
+    int rows() const { return rowCount; }
+    int columns() const { return columnCount; }
+    int wordsPerRow() const { return stride; }
+    bool isEmpty() const { return bits.empty(); }
+
+    uint64_t* row(int r) { return bits.data() + static_cast<size_t>(r) * stride; }
+    const uint64_t* row(int r) const { return bits.data() + static_cast<size_t>(r) * stride; }
+
+    bool test(int r, int c) const { return row(r)[c / 64] >> (c % 64) & 1; }
+    void set(int r, int c) { row(r)[c / 64] |= uint64_t(1) << (c % 64); }
+    void reset(int r, int c) { row(r)[c / 64] &= ~(uint64_t(1) << (c % 64)); }
+    void clear() { std::fill(bits.begin(), bits.end(), 0); }
+
+    bool rowAny(int r) const {
+        const uint64_t* words = row(r);
+        return std::any_of(words, words + stride, [](uint64_t word) { return word != 0; });
+    }
+    size_t count() const {
+        size_t total = 0;
+        for (uint64_t word : bits) total += std::bitset<64>(word).count();
+        return total;
+    }
+
+private:
+    int rowCount = 0;
+    int columnCount = 0;
+    int stride = 0;
+    std::vector<uint64_t> bits;
+};
+
+#endif // BITGRID_H
@@ -0,0 +1,127 @@
+#include "DiffPanel.h"
+
+#include <QDir>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QVBoxLayout>
+
+namespace {
+
+// Levels listed per group; a diff against an unrelated pack can touch every level.
+constexpr int maxListedChanges = 2000;
+
+const char* groupTitle(packdiff::Change change) {
+    switch (change) {
+        case packdiff::Change::Unchanged:  return "Unchanged";
+        case packdiff::Change::Modified:   return "Changed levels";
+        case packdiff::Change::Added:      return "Only in this pack";
+        case packdiff::Change::Removed:    return "Only in the other pack";
+        case packdiff::Change::Renumbered: return "Renumbered levels";
+    }
+    return "Other";
+}
+
+QString describe(const packdiff::LevelDiff& level) {
+    switch (level.change) {
+        case packdiff::Change::Modified: {
+            QStringList parts;
+            if (!level.changedRows.empty())
+                parts << QString("%1 %2 changed").arg(level.changedRows.size()).arg(level.changedRows.size() == 1 ? "row" : "rows");
+            if (level.resized) parts << "resized";
+            if (level.linksChanged) parts << "links changed";
+            return QString("Level %1: %2").arg(level.afterNumber).arg(parts.join(", "));
+        }
+        case packdiff::Change::Removed:
+            return QString("Level %1").arg(level.beforeNumber);
+        case packdiff::Change::Renumbered:
+            return QString("Level %1, was %2").arg(level.afterNumber).arg(level.beforeNumber);
+        default:
+            return QString("Level %1").arg(level.afterNumber);
+    }
+}
+
+} // namespace
+
+DiffPanel::DiffPanel(QWidget *parent)
+    : QWidget(parent)
+{
+    auto* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    auto* compareButton = new QPushButton("Compare with...");
+    compareButton->setToolTip("List the levels that differ from another pack file");
+    connect(compareButton, &QPushButton::clicked, this, &DiffPanel::compare);
+    layout->addWidget(compareButton);
+
+    status = new QLabel;
+    status->setWordWrap(true);
+    layout->addWidget(status);
+
+    changes = new QTreeWidget;
+    changes->setHeaderHidden(true);
+    changes->setUniformRowHeights(true);
+    const auto activate = [this](QTreeWidgetItem* item) {
+        const QVariant index = item->data(0, Qt::UserRole);
+        if (index.isValid() && activated) activated(index.toInt());
+    };
+    connect(changes, &QTreeWidget::itemClicked, this, activate);
+    connect(changes, &QTreeWidget::itemActivated, this, activate);
+    layout->addWidget(changes, 1);
+}
+
+void DiffPanel::compare() {
+    const QString path = QFileDialog::getOpenFileName(this, "Compare With Pack", lastPath.isEmpty() ? QDir::homePath() : lastPath,
+                                                      "Level Packs (*.rll *.rlb);;All Files (*)");
+    if (path.isEmpty()) return;
+    lastPath = path;
+    reset();
+    status->setText(QString("Comparing with %1...").arg(QFileInfo(path).fileName()));
+    if (compareHandler) compareHandler(path);
+}
+
+void DiffPanel::reset() {
+    changes->clear();
+    status->clear();
+}
+
+void DiffPanel::showComparison(const PackComparer::Comparison& comparison) {
+    const QString name = QFileInfo(comparison.path).fileName();
+    changes->clear();
+    if (!comparison.error.isEmpty()) {
+        status->setText(QString("Cannot read %1: %2").arg(name, comparison.error));
+        return;
+    }
+    const packdiff::PackDiff& diff = comparison.diff;
+    if (diff.isEmpty()) {
+        status->setText(QString("Same levels as %1 (%2 s)").arg(name).arg(comparison.milliseconds / 1000.0, 0, 'f', 2));
+        return;
+    }
+    status->setText(QString("Compared with %1: %2 unchanged (%3 s)")
+                        .arg(name).arg(diff.unchanged).arg(comparison.milliseconds / 1000.0, 0, 'f', 2));
+
+    changes->setUpdatesEnabled(false);
+    const packdiff::Change order[] = {packdiff::Change::Modified, packdiff::Change::Added, packdiff::Change::Removed,
+                                      packdiff::Change::Renumbered};
+    QTreeWidgetItem* groups[5] = {};
+    for (const packdiff::Change change : order) groups[static_cast<int>(change)] = new QTreeWidgetItem(changes);
+    for (size_t i = 0; i < diff.levels.size(); ++i) {
+        const packdiff::LevelDiff& level = diff.levels[i];
+        QTreeWidgetItem* group = groups[static_cast<int>(level.change)];
+        if (!group || group->childCount() >= maxListedChanges) continue;
+        auto* item = new QTreeWidgetItem(group, {describe(level)});
+        item->setData(0, Qt::UserRole, static_cast<int>(i));
+    }
+    const size_t counts[] = {diff.modified, diff.added, diff.removed, diff.renumbered};
+    for (int i = 0; i < 4; ++i) {
+        QTreeWidgetItem* group = groups[static_cast<int>(order[i])];
+        if (counts[i] == 0) {
+            delete group;
+            continue;
+        }
+        group->setText(0, QString("%1 (%2)").arg(groupTitle(order[i])).arg(counts[i]));
+        if (counts[i] > static_cast<size_t>(group->childCount()))
+            new QTreeWidgetItem(group, {QString("... and %1 more").arg(counts[i] - group->childCount())});
+    }
+    changes->topLevelItem(0)->setExpanded(true);
+    changes->setUpdatesEnabled(true);
+}
@@ -0,0 +1,36 @@
+#ifndef DIFFPANEL_H
+#define DIFFPANEL_H
+
+#include <QLabel>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <functional>
+#include "PackComparer.h"
+
+// The changes between the open pack and another pack file, one group per kind of
+// change. Activating a level passes its position in PackDiff::levels to the
+// activation handler.
+class DiffPanel : public QWidget
+{
+public:
+    explicit DiffPanel(QWidget *parent = nullptr);
+
+    // Called with the file the user picked to compare the open pack with.
+    void setCompareHandler(std::function<void(const QString&)> handler) { compareHandler = std::move(handler); }
+    void setChangeActivatedHandler(std::function<void(int)> handler) { activated = std::move(handler); }
+
+    void showComparison(const PackComparer::Comparison& comparison);
+    // Forgets the comparison, e.g. when it no longer describes the loaded pack.
+    void reset();
+
+private:
+    void compare();
+
+    QLabel* status;
+    QTreeWidget* changes;
+    QString lastPath;
+    std::function<void(const QString&)> compareHandler;
+    std::function<void(int)> activated;
+};
+
+#endif // DIFFPANEL_H
@@ -0,0 +1,135 @@
+#include "EditHistory.h"
+
+#include <algorithm>
+
+void EditHistory::setMemoryBudget(size_t bytes) {
+    budget = bytes;
+    trim();
+}
+
+void EditHistory::beginStroke() {
+    if (recording) commit();
+    recording = true;
+}
+
+void EditHistory::endStroke() {
+    if (!recording) return;
+    recording = false;
+    commit();
+}
+
+void EditHistory::record(const TileMap& map, int row, int col, char after) {
+    if (!map.contains(row, col)) return;
+    const char before = map.at(row, col);
+    if (before == after) return;
+    append(static_cast<size_t>(row) * map.columns() + col, before, after);
+    if (!recording) commit();
+}
+
+void EditHistory::recordFill(const TileMap& map, char after) {
+    const bool inStroke = recording;
+    recording = true;
+    for (int row = 0; row < map.rows(); ++row) recordRow(map, row, 0, map.columns() - 1, after);
+    recording = inStroke;
+    if (!recording) commit();
+}
+
+void EditHistory::recordRow(const TileMap& map, int row, int firstCol, int lastCol, char after) {
+    rowTiles.resize(static_cast<size_t>(lastCol - firstCol + 1));
+    map.readRow(row, firstCol, lastCol - firstCol + 1, rowTiles.data());
+    const size_t start = static_cast<size_t>(row) * map.columns() + firstCol;
+    for (size_t i = 0; i < rowTiles.size(); ++i) {
+        if (rowTiles[i] != after) append(start + i, rowTiles[i], after);
+    }
+    if (!recording) commit();
+}
+
+void EditHistory::recordPaste(const TileMap& map, const TileMap& tiles, int row, int col) {
+    const int first = std::max(col, 0);
+    const int last = std::min(col + tiles.columns(), map.columns()) - 1;
+    if (first <= last) {
+        const auto count = static_cast<size_t>(last - first + 1);
+        rowTiles.resize(count);
+        pastedTiles.resize(count);
+        for (int r = std::max(row, 0); r < std::min(row + tiles.rows(), map.rows()); ++r) {
+            map.readRow(r, first, static_cast<int>(count), rowTiles.data());
+            tiles.readRow(r - row, first - col, static_cast<int>(count), pastedTiles.data());
+            const size_t start = static_cast<size_t>(r) * map.columns() + first;
+            for (size_t i = 0; i < count; ++i) {
+                if (rowTiles[i] != pastedTiles[i]) append(start + i, rowTiles[i], pastedTiles[i]);
+            }
+        }
+    }
+    if (!recording) commit();
+}
+
+void EditHistory::append(size_t index, char before, char after) {
+    const auto position = static_cast<uint32_t>(index);
+    if (current.segments.empty() || current.segments.back().start + current.segments.back().length != position)
+        current.segments.push_back({position, 0});
+    current.segments.back().length++;
+    current.before.push_back(before);
+    current.after.push_back(after);
+}
+
+void EditHistory::commit() {
+    if (current.isEmpty()) return;
+    current.segments.shrink_to_fit();
+    current.before.shrink_to_fit();
+    current.after.shrink_to_fit();
+    for (const Entry& entry : redoEntries) usage -= entry.bytes();
+    redoEntries.clear();
+    usage += current.bytes();
+    undoEntries.push_back(std::move(current));
+    current = Entry();
+    trim();
+}
+
+void EditHistory::trim() {
+    // The newest entry always survives, so even an edit larger than the budget can be undone once.
+    while (usage > budget && !redoEntries.empty()) {
+        usage -= redoEntries.front().bytes();
+        redoEntries.pop_front();
+    }
+    while (usage > budget && undoEntries.size() > 1) {
+        usage -= undoEntries.front().bytes();
+        undoEntries.pop_front();
+    }
+}
+
+bool EditHistory::undo(TileMap& map) {
+    endStroke();
+    if (undoEntries.empty()) return false;
+    Entry entry = std::move(undoEntries.back());
+    undoEntries.pop_back();
+
+    // Walk backwards so a cell touched twice in one stroke ends at its first "before".
+    size_t tile = entry.before.size();
+    for (auto segment = entry.segments.rbegin(); segment != entry.segments.rend(); ++segment) {
+        for (uint32_t i = segment->length; i-- > 0;) map.setIndex(segment->start + i, entry.before[--tile]);
+    }
+    redoEntries.push_back(std::move(entry));
+    return true;
+}
+
+bool EditHistory::redo(TileMap& map) {
+    endStroke();
+    if (redoEntries.empty()) return false;
+    Entry entry = std::move(redoEntries.back());
+    redoEntries.pop_back();
+
+    size_t tile = 0;
+    for (const Segment& segment : entry.segments) {
+        for (uint32_t i = 0; i < segment.length; ++i) map.setIndex(segment.start + i, entry.after[tile++]);
+    }
+    undoEntries.push_back(std::move(entry));
+    return true;
+}
+
+void EditHistory::clear() {
+    undoEntries.clear();
+    redoEntries.clear();
+    current = Entry();
+    recording = false;
+    usage = 0;
+}
@@ -0,0 +1,75 @@
+#ifndef EDITHISTORY_H
+#define EDITHISTORY_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include "TileMap.h"
+
+// Undo/redo history of tile edits. Each entry stores only the cells it changed, as
+// runs of consecutive indices with the tiles before and after, so a stroke, fill or
+// clear costs about two bytes per changed cell. Everything recorded between
+// beginStroke() and endStroke() becomes one entry. The oldest entries are dropped
+// once the history outgrows its memory budget.
+class EditHistory
+{
+public:
+    static constexpr size_t defaultMemoryBudget = size_t(16) << 20;
+
+    explicit EditHistory(size_t memoryBudget = defaultMemoryBudget) : budget(memoryBudget) {}
+
+    size_t memoryBudget() const { return budget; }
+    void setMemoryBudget(size_t bytes);
+    size_t memoryUsage() const { return usage; }
+
+    void beginStroke();
+    void endStroke();
+    bool inStroke() const { return recording; }
+
+    // Records a change about to be made to map; outside a stroke it becomes its own entry.
+    void record(const TileMap& map, int row, int col, char after);
+    void recordFill(const TileMap& map, char after);
+    // Records cells firstCol..lastCol of one row; callers keep the range inside the map.
+    void recordRow(const TileMap& map, int row, int firstCol, int lastCol, char after);
+    // Records a TileMap::paste() of tiles at (row, col).
+    void recordPaste(const TileMap& map, const TileMap& tiles, int row, int col);
+
+    bool canUndo() const { return !undoEntries.empty(); }
+    bool canRedo() const { return !redoEntries.empty(); }
+    bool undo(TileMap& map);
+    bool redo(TileMap& map);
+    void clear();
+
+private:
+    struct Segment {
+        uint32_t start;
+        uint32_t length;
+    };
+
+    struct Entry {
+        std::vector<Segment> segments;
+        std::string before;
+        std::string after;
+
+        bool isEmpty() const { return segments.empty(); }
+        size_t bytes() const {
+            return sizeof(Entry) + segments.capacity() * sizeof(Segment) + before.capacity() + after.capacity();
+        }
+    };
+
+    void append(size_t index, char before, char after);
+    void commit();
+    void trim();
+
+    std::deque<Entry> undoEntries;
+    std::deque<Entry> redoEntries;
+    Entry current;
+    std::string rowTiles;
+    std::string pastedTiles;
+    bool recording = false;
+    size_t budget;
+    size_t usage = 0;
+};
+
+#endif // EDITHISTORY_H
@@ -0,0 +1,388 @@
+// level-editor-bench: how long the editor window takes to handle scripted input and
+// to repaint the canvas afterwards, run under the offscreen platform.
+//
+//   level-editor-bench [options]
+//
+// Options: --seed N, --levels N, --size N, --baseline FILE [--threshold PERCENT],
+//          --write-baseline FILE.
+//
+// The window runs in a scratch directory holding a generated pack of size x size
+// levels and a copy of data/sprites from the working directory, so the real saves
+// are never touched. Input is synthesized as mouse and key events sent to the same
+// widgets real input reaches: the canvas viewport (MainWindow::eventFilter), the
+// level list and the main window's shortcuts. Each scenario reports the p50, p99
+// and maximum time of its interactions and of the canvas paints they caused, as
+// JSON on stdout.
+//
+// A baseline file holds one "scenario/event-p99 ms" and one "scenario/paint-p99 ms"
+// line per scenario. With --baseline, a value more than --threshold percent
+// (default 25) above its baseline line is a regression.
+// Exit code 0 when nothing regressed, 1 on a regression or an unexpected dialog,
+// 2 on usage errors.
+
+#include <QApplication>
+#include <QtWidgets>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "LevelCanvas.h"
+#include "LevelGenerator.h"
+#include "MainWindow.h"
+#include "RleCodec.h"
+
+namespace {
+
+struct Options {
+    uint32_t seed = 1;
+    int levels = 20;
+    int size = 256;
+    double threshold = 25;
+    std::string baselinePath;
+    std::string writeBaselinePath;
+};
+
+struct Scenario {
+    std::string name;
+    std::vector<double> events;
+    std::vector<double> paints;
+};
+
+// Nearest-rank percentile in milliseconds.
+double percentile(std::vector<double> values, double fraction) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    const auto rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(values.size())));
+    return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+}
+
+bool writePack(const QString& path, const Options& options) {
+    std::string pack;
+    std::string encoded;
+    const std::vector<rle::Level> levels = levelgen::generatePack(static_cast<size_t>(options.levels), options.size,
+                                                                  options.size, options.seed);
+    for (size_t i = 0; i < levels.size(); ++i) {
+        rle::encode(levels[i], encoded);
+        rle::appendPackRecord(static_cast<int>(i + 1), encoded, pack);
+    }
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+        && file.write(pack.data(), static_cast<qint64>(pack.size())) == static_cast<qint64>(pack.size());
+}
+
+// Sends input to a MainWindow and collects timings into the current scenario.
+class Driver
+{
+public:
+    explicit Driver(MainWindow& window)
+    : window(window)
+    {
+        // The editor's widgets have no Q_OBJECT, so they are told apart by their C++ type.
+        for (QAbstractScrollArea* area : window.findChildren<QAbstractScrollArea*>()) {
+            if (auto* found = dynamic_cast<LevelCanvas*>(area)) canvas = found;
+            auto* list = qobject_cast<QListView*>(area);
+            if (list && dynamic_cast<LevelListModel*>(list->model())) levelList = list;
+        }
+        if (!isReady()) return;
+        canvas->setPaintTimeHandler([this](qint64 nanoseconds) {
+            if (current) current->paints.push_back(nanoseconds / 1e6);
+        });
+        // Modal dialogs run their own event loop, so this still fires while one is open.
+        dialogGuard.setInterval(10);
+        QObject::connect(&dialogGuard, &QTimer::timeout, &dialogGuard, [this] { answerDialog(); });
+        dialogGuard.start();
+    }
+
+    bool isReady() const { return canvas && levelList; }
+    QStringList unexpectedDialogs() const { return dialogs; }
+
+    void begin(const std::string& name) {
+        scenarios.push_back({name, {}, {}});
+        current = &scenarios.back();
+        settle();
+        current->paints.clear();
+    }
+
+    void end() {
+        settle();
+        current = nullptr;
+    }
+
+    const std::vector<Scenario>& results() const { return scenarios; }
+
+    // Times one interaction, then lets queued work (repaints, analyzer results) run
+    // the way the event loop would before the next input arrives.
+    template <typename Interaction>
+    void timed(Interaction&& interaction) {
+        QElapsedTimer clock;
+        clock.start();
+        interaction();
+        const double milliseconds = clock.nsecsElapsed() / 1e6;
+        if (current) current->events.push_back(milliseconds);
+        QCoreApplication::processEvents();
+    }
+
+    // Runs the event loop long enough for batched canvas updates to reach the screen.
+    void settle() {
+        QEventLoop loop;
+        QTimer::singleShot(50, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+
+    void mouse(QWidget* target, QEvent::Type type, const QPoint& position, Qt::MouseButtons buttons) {
+        QMouseEvent event(type, position, target->mapToGlobal(position),
+                          type == QEvent::MouseMove ? Qt::NoButton : Qt::LeftButton, buttons, Qt::NoModifier);
+        QApplication::sendEvent(target, &event);
+    }
+
+    void key(int key, Qt::KeyboardModifiers modifiers = Qt::ControlModifier) {
+        QKeyEvent event(QEvent::KeyPress, key, modifiers);
+        QApplication::sendEvent(&window, &event);
+    }
+
+    // One pencil stroke across the canvas along a wave; every event is timed when timing.
+    void stroke(int index, int moves, bool timing) {
+        QWidget* viewport = canvas->viewport();
+        const QRect area = viewport->rect().adjusted(8, 8, -8, -8);
+        const auto point = [&](int step) {
+            const double t = double(step) / moves;
+            const double wave = std::sin(t * 6.283 * 3 + index);
+            return QPoint(area.left() + qRound(t * area.width()),
+                          area.center().y() + qRound(wave * area.height() * 0.4 * (1 - index % 5 * 0.15)));
+        };
+        const auto send = [&](QEvent::Type type, const QPoint& position, Qt::MouseButtons buttons) {
+            if (timing) timed([&] { mouse(viewport, type, position, buttons); });
+            else mouse(viewport, type, position, buttons);
+        };
+        send(QEvent::MouseButtonPress, point(0), Qt::LeftButton);
+        for (int step = 1; step <= moves; ++step) send(QEvent::MouseMove, point(step), Qt::LeftButton);
+        send(QEvent::MouseButtonRelease, point(moves), Qt::NoButton);
+    }
+
+    void clickLevel(int row) {
+        const QModelIndex index = levelList->model()->index(row, 0);
+        levelList->scrollTo(index);
+        QCoreApplication::processEvents();
+        const QPoint position = levelList->visualRect(index).center();
+        timed([&] {
+            mouse(levelList->viewport(), QEvent::MouseButtonPress, position, Qt::LeftButton);
+            mouse(levelList->viewport(), QEvent::MouseButtonRelease, position, Qt::NoButton);
+        });
+    }
+
+    void resizeLevel(int columns, int rows) {
+        // Answer the dialog on its first event loop pass so the wait is not part of the time.
+        pendingResize = QSize(columns, rows);
+        dialogGuard.setInterval(0);
+        timed([&] { key(Qt::Key_R); });
+        dialogGuard.setInterval(10);
+        if (pendingResize.isValid()) dialogs << "the resize dialog did not open";
+        pendingResize = QSize();
+    }
+
+    int levelCount() const { return levelList->model()->rowCount(); }
+    QSize canvasSize() const { return {canvas->columnCount(), canvas->rowCount()}; }
+
+private:
+    void answerDialog() {
+        auto* dialog = qobject_cast<QDialog*>(QApplication::activeModalWidget());
+        if (!dialog) return;
+        if (pendingResize.isValid() && !qobject_cast<QMessageBox*>(dialog)) {
+            auto* form = dialog->findChild<QFormLayout*>();
+            auto* apply = dialog->findChild<QPushButton*>();
+            if (form && apply) {
+                qobject_cast<QLineEdit*>(form->itemAt(0, QFormLayout::FieldRole)->widget())->setText(QString::number(pendingResize.width()));
+                qobject_cast<QLineEdit*>(form->itemAt(1, QFormLayout::FieldRole)->widget())->setText(QString::number(pendingResize.height()));
+                pendingResize = QSize();
+                apply->click();
+                return;
+            }
+        }
+        auto* box = qobject_cast<QMessageBox*>(dialog);
+        dialogs << (box ? box->text() : dialog->windowTitle());
+        dialog->reject();
+    }
+
+    MainWindow& window;
+    LevelCanvas* canvas = nullptr;
+    QListView* levelList = nullptr;
+    QTimer dialogGuard;
+    QSize pendingResize;
+    QStringList dialogs;
+    std::vector<Scenario> scenarios;
+    Scenario* current = nullptr;
+};
+
+void runScenarios(Driver& driver) {
+    // Switching first: the window starts without unsaved edits, so no dialog asks about them.
+    driver.begin("level-switch");
+    for (int i = 0; i < 40; ++i) driver.clickLevel((i + 1) % driver.levelCount());
+    driver.end();
+
+    driver.begin("drag-stroke");
+    for (int i = 0; i < 20; ++i) driver.stroke(i, 200, true);
+    driver.end();
+
+    for (int i = 0; i < 8; ++i) driver.key(Qt::Key_Plus);
+    driver.begin("drag-stroke-zoomed");
+    for (int i = 0; i < 20; ++i) driver.stroke(i, 200, true);
+    driver.end();
+    driver.key(Qt::Key_0);
+
+    driver.begin("save");
+    for (int i = 0; i < 20; ++i) {
+        driver.stroke(i, 2, false);
+        driver.timed([&] { driver.key(Qt::Key_S); });
+    }
+    driver.end();
+
+    for (int i = 0; i < 60; ++i) driver.stroke(i, 40, false);
+    driver.begin("undo-burst");
+    for (int i = 0; i < 60; ++i) driver.timed([&] { driver.key(Qt::Key_Z); });
+    driver.end();
+
+    const QSize original = driver.canvasSize();
+    driver.begin("level-resize");
+    for (int i = 0; i < 10; ++i) {
+        if (i % 2) driver.resizeLevel(original.width(), original.height());
+        else driver.resizeLevel(original.width() + 64, original.height() + 32);
+    }
+    driver.end();
+}
+
+bool readBaseline(const std::string& path, std::map<std::string, double>& baseline) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string name;
+        double milliseconds = 0;
+        if (fields >> name >> milliseconds) baseline[name] = milliseconds;
+    }
+    return true;
+}
+
+int usage(const char* message) {
+    if (message) std::cerr << "level-editor-bench: " << message << '\n';
+    std::cerr << "usage: level-editor-bench [--seed N] [--levels N] [--size N]\n"
+                 "                          [--baseline FILE [--threshold PERCENT]] [--write-baseline FILE]\n";
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (argument == "--seed" && hasValue) options.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (argument == "--levels" && hasValue) options.levels = std::max(2, std::atoi(argv[++i]));
+        else if (argument == "--size" && hasValue) options.size = std::clamp(std::atoi(argv[++i]), 8, 4096);
+        else if (argument == "--threshold" && hasValue) options.threshold = std::max(0.0, std::atof(argv[++i]));
+        else if (argument == "--baseline" && hasValue) options.baselinePath = argv[++i];
+        else if (argument == "--write-baseline" && hasValue) options.writeBaselinePath = argv[++i];
+        else return usage(("unknown option " + argument).c_str());
+    }
+
+    std::map<std::string, double> baseline;
+    if (!options.baselinePath.empty() && !readBaseline(options.baselinePath, baseline))
+        return usage(("unable to read " + options.baselinePath).c_str());
+    // Resolved before the working directory moves to the scratch directory.
+    const QString writeBaselinePath = options.writeBaselinePath.empty()
+        ? QString() : QFileInfo(QString::fromStdString(options.writeBaselinePath)).absoluteFilePath();
+
+    QTemporaryDir scratch;
+    if (!scratch.isValid()) return usage("unable to create a scratch directory");
+    const QDir sprites("data/sprites");
+    if (!sprites.exists()) std::cerr << "level-editor-bench: no data/sprites here, tiles will paint without sprites\n";
+    QDir(scratch.path()).mkpath("data/sprites");
+    QDir(scratch.path()).mkpath("data/saves");
+    for (const QString& name : sprites.entryList(QDir::Files))
+        QFile::copy(sprites.filePath(name), scratch.filePath("data/sprites/" + name));
+    if (!writePack(scratch.filePath("data/saves/levels.rll"), options)) return usage("unable to write the level pack");
+    QDir::setCurrent(scratch.path());
+
+    std::vector<Scenario> scenarios;
+    QStringList dialogs;
+    {
+        MainWindow window;
+        window.show();
+        Driver driver(window);
+        if (!driver.isReady()) {
+            std::cerr << "level-editor-bench: the window has no level canvas or level list\n";
+            return 1;
+        }
+        driver.settle();
+        runScenarios(driver);
+        scenarios = driver.results();
+        dialogs = driver.unexpectedDialogs();
+    }
+
+    bool failed = !dialogs.isEmpty();
+    for (const QString& dialog : dialogs) std::cerr << "level-editor-bench: unexpected dialog: " << dialog.toStdString() << '\n';
+
+    std::string out = "{\"platform\":\"" + QGuiApplication::platformName().toStdString() + "\",\"seed\":"
+                    + std::to_string(options.seed) + ",\"levels\":" + std::to_string(options.levels) + ",\"size\":"
+                    + std::to_string(options.size) + ",\"scenarios\":[";
+    std::string baselineOut = "# level-editor-bench baseline: measurement milliseconds\n";
+    size_t regressions = 0;
+    char number[64];
+    const auto field = [&](const char* name, double value) {
+        std::snprintf(number, sizeof(number), ",\"%s\":%.4f", name, value);
+        out += number;
+    };
+    for (size_t i = 0; i < scenarios.size(); ++i) {
+        const Scenario& scenario = scenarios[i];
+        if (i > 0) out += ',';
+        out += "{\"name\":\"" + scenario.name + "\",\"events\":" + std::to_string(scenario.events.size())
+             + ",\"paints\":" + std::to_string(scenario.paints.size());
+        field("eventP50Ms", percentile(scenario.events, 0.5));
+        field("eventP99Ms", percentile(scenario.events, 0.99));
+        field("eventMaxMs", percentile(scenario.events, 1));
+        field("paintP50Ms", percentile(scenario.paints, 0.5));
+        field("paintP99Ms", percentile(scenario.paints, 0.99));
+        field("paintMaxMs", percentile(scenario.paints, 1));
+
+        std::string regressed;
+        const auto compare = [&](const char* measurement, const std::vector<double>& values) {
+            const std::string name = scenario.name + '/' + measurement;
+            const double value = percentile(values, 0.99);
+            std::snprintf(number, sizeof(number), " %.4f\n", value);
+            baselineOut += name + number;
+            const auto line = baseline.find(name);
+            if (line == baseline.end() || value <= line->second * (1 + options.threshold / 100)) return;
+            if (!regressed.empty()) regressed += ',';
+            regressed += '"' + std::string(measurement) + '"';
+            ++regressions;
+        };
+        compare("event-p99", scenario.events);
+        compare("paint-p99", scenario.paints);
+        if (!baseline.empty()) out += ",\"regressed\":[" + regressed + ']';
+        out += '}';
+    }
+    out += "],\"unexpectedDialogs\":" + std::to_string(dialogs.size()) + ",\"regressions\":"
+         + std::to_string(regressions) + "}\n";
+    std::cout << out;
+
+    if (!writeBaselinePath.isEmpty()) {
+        std::ofstream file(writeBaselinePath.toStdString(), std::ios::trunc);
+        file << baselineOut;
+        if (!file) {
+            std::cerr << "level-editor-bench: unable to write " << options.writeBaselinePath << '\n';
+            return 1;
+        }
+    }
+    return failed || regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,456 @@
+// level-bench: throughput of the level codecs and pack I/O on seeded synthetic levels.
+//
+//   level-bench [options]
+//
+// Options: --seed N, --quick, --filter TEXT, --min-time SECONDS, --json,
+//          --baseline FILE [--threshold PERCENT], --write-baseline FILE.
+//
+// rll-encode and rll-decode time the codec behind encrypt() and decrypt() in
+// utilities.h; rlb-* the binary format. pack-save encodes a whole pack and writes
+// it to disk, pack-load reads it back and decodes every level, and pack-index
+// builds the level list the editor's model shows (numbers and "Level N" names);
+// rlb-shared is the binary format with shared rows.
+// MB/s counts encoded bytes, tiles/s decoded tiles. Each benchmark reports the
+// median of at least three runs.
+//
+// A baseline file holds one "name tiles-per-second" line per benchmark. With
+// --baseline, a benchmark regresses when it is more than --threshold percent
+// (default 10) slower than its baseline line.
+// Exit code 0 when nothing regressed, 1 on a regression or a round-trip mismatch,
+// 2 on usage errors.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "LevelGenerator.h"
+#include "RleCodec.h"
+#include "RlbFormat.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int minIterations = 3;
+
+struct Options {
+    uint32_t seed = 1;
+    bool quick = false;
+    bool json = false;
+    double minTime = 0.5;
+    double threshold = 10;
+    std::string filter;
+    std::string baselinePath;
+    std::string writeBaselinePath;
+};
+
+struct Benchmark {
+    std::string name;
+    size_t tiles = 0;
+    size_t bytes = 0;
+    std::function<void()> run;
+    // Returns an empty string when the last run produced the expected result.
+    std::function<std::string()> verify;
+};
+
+struct Result {
+    std::string name;
+    int iterations = 0;
+    double seconds = 0;
+    size_t tiles = 0;
+    size_t bytes = 0;
+    double baseline = 0;
+    bool regressed = false;
+
+    double tilesPerSecond() const { return seconds > 0 ? tiles / seconds : 0; }
+    double megabytesPerSecond() const { return seconds > 0 ? bytes / seconds / 1e6 : 0; }
+};
+
+std::string levelName(int number) {
+    return "Level " + std::to_string(number);
+}
+
+bool sameTiles(const rle::Level& a, const rle::Level& b) {
+    return a.rows == b.rows && a.columns == b.columns && a.tiles == b.tiles
+        && std::equal(a.nextLevel, a.nextLevel + 4, b.nextLevel);
+}
+
+std::string buildPack(const std::vector<rle::Level>& levels, bool binary, bool sharedRows, std::string& scratch) {
+    std::string out;
+    if (binary) {
+        rlb::PackWriter writer(sharedRows);
+        out.append(rlb::headerSize, '\0');
+        for (size_t i = 0; i < levels.size(); ++i) writer.add(static_cast<int>(i + 1), levels[i], out);
+        char bytes[rlb::headerSize];
+        writer.finish(out, bytes);
+        out.replace(0, rlb::headerSize, bytes, rlb::headerSize);
+    }
+    else {
+        for (size_t i = 0; i < levels.size(); ++i) {
+            rle::encode(levels[i], scratch);
+            rle::appendPackRecord(static_cast<int>(i + 1), scratch, out);
+        }
+    }
+    return out;
+}
+
+bool writeFile(const fs::path& path, const std::string& content) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    return bool(file);
+}
+
+std::string readFile(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+// Offsets and lengths of every record, the way LevelPack indexes an opened file.
+std::vector<rle::PackRecord> indexPack(std::string_view content) {
+    if (!rlb::isRlb(content)) return rle::scanPack(content);
+    std::vector<rle::PackRecord> records;
+    rlb::PackReader reader;
+    if (reader.open(content)) return records;
+    records.reserve(reader.count());
+    for (uint32_t i = 0; i < reader.count(); ++i) {
+        const rlb::TableEntry entry = reader.entry(i);
+        records.push_back({entry.number, static_cast<size_t>(entry.offset), entry.length});
+    }
+    return records;
+}
+
+// Shared state of the benchmarks over one generated level or pack; the closures
+// of Benchmark point into it, so it lives until every benchmark has run.
+struct CodecCase {
+    rle::Level level;
+    std::string output;
+    rle::Level decoded;
+};
+
+struct PackCase {
+    std::vector<rle::Level> levels;
+    bool binary = false;
+    bool sharedRows = false;
+    fs::path path;
+    std::string scratch;
+    std::string content;
+    std::vector<rle::PackRecord> records;
+    std::vector<std::string> names;
+    rle::Level decoded;
+    size_t decodedLevels = 0;
+    size_t failedLevels = 0;
+    bool written = false;
+};
+
+void addCodecBenchmarks(std::vector<Benchmark>& benchmarks, std::vector<std::unique_ptr<CodecCase>>& cases,
+                        const Options& options, levelgen::Pattern pattern, int size) {
+    const std::string suffix = std::string("/") + levelgen::patternName(pattern) + '/' + std::to_string(size) + 'x'
+                             + std::to_string(size);
+    const auto wanted = [&](const std::string& name) {
+        return options.filter.empty() || name.find(options.filter) != std::string::npos;
+    };
+    bool any = false;
+    for (const char* prefix : {"rll-encode", "rll-decode", "rlb-encode", "rlb-decode"}) any = any || wanted(prefix + suffix);
+    if (!any) return;
+
+    cases.push_back(std::make_unique<CodecCase>());
+    CodecCase& data = *cases.back();
+    data.level = levelgen::generate(pattern, size, size, options.seed);
+    const size_t tiles = data.level.tiles.size();
+
+    for (const bool binary : {false, true}) {
+        std::string encoded;
+        if (binary) rlb::encodeLevel(data.level, encoded);
+        else rle::encode(data.level, encoded);
+        const std::string format = binary ? "rlb" : "rll";
+
+        if (wanted(format + "-encode" + suffix)) {
+            benchmarks.push_back({format + "-encode" + suffix, tiles, encoded.size(),
+                [&data, binary] {
+                    data.output.clear();
+                    if (binary) rlb::encodeLevel(data.level, data.output);
+                    else rle::encode(data.level, data.output);
+                },
+                [&data, binary, encoded]() -> std::string {
+                    if (data.output != encoded) return "output differs between runs";
+                    if (binary) return {};
+                    // The run above used the widest SIMD path; the scalar one must agree byte for byte.
+                    const rle::SimdLevel fastest = rle::simdLevel();
+                    rle::setSimdLevel(rle::SimdLevel::Scalar);
+                    std::string scalar;
+                    rle::encode(data.level, scalar);
+                    rle::setSimdLevel(fastest);
+                    return scalar == encoded ? std::string() : "scalar and SIMD encoders disagree";
+                }});
+        }
+        if (wanted(format + "-decode" + suffix)) {
+            benchmarks.push_back({format + "-decode" + suffix, tiles, encoded.size(),
+                [&data, binary, encoded] {
+                    const rle::Error error = binary ? rlb::decodeLevel(encoded, data.decoded)
+                                                    : rle::decode(encoded, data.decoded);
+                    if (error) data.decoded.rows = -1;
+                },
+                [&data]() -> std::string {
+                    return sameTiles(data.level, data.decoded) ? std::string() : "decoded level differs from the original";
+                }});
+        }
+    }
+}
+
+void addPackBenchmarks(std::vector<Benchmark>& benchmarks, std::vector<std::unique_ptr<PackCase>>& cases,
+                       const Options& options, const fs::path& directory, size_t count) {
+    const auto wanted = [&](const std::string& name) {
+        return options.filter.empty() || name.find(options.filter) != std::string::npos;
+    };
+    const std::string suffix = '/' + std::to_string(count);
+    std::vector<rle::Level> levels;
+    for (const std::string format : {"rll", "rlb", "rlb-shared"}) {
+        const bool binary = format != "rll";
+        const std::string save = "pack-save/" + format + suffix;
+        const std::string load = "pack-load/" + format + suffix;
+        const std::string index = "pack-index/" + format + suffix;
+        if (!wanted(save) && !wanted(load) && !wanted(index)) continue;
+
+        if (levels.empty()) levels = levelgen::generatePack(count, 16, 48, options.seed);
+        cases.push_back(std::make_unique<PackCase>());
+        PackCase& data = *cases.back();
+        data.levels = levels;
+        data.binary = binary;
+        data.sharedRows = format == "rlb-shared";
+        data.path = directory / ("pack." + format);
+        data.content = buildPack(data.levels, binary, data.sharedRows, data.scratch);
+        const size_t bytes = data.content.size();
+        size_t tiles = 0;
+        for (const rle::Level& level : data.levels) tiles += level.tiles.size();
+        if (!writeFile(data.path, data.content)) {
+            std::cerr << "level-bench: unable to write " << data.path.string() << '\n';
+            std::exit(1);
+        }
+
+        if (wanted(save)) {
+            benchmarks.push_back({save, tiles, bytes,
+                [&data] {
+                    data.written = writeFile(data.path, buildPack(data.levels, data.binary, data.sharedRows, data.scratch));
+                },
+                [&data, bytes]() -> std::string {
+                    if (!data.written) return "unable to write " + data.path.string();
+                    return fs::file_size(data.path) == bytes ? std::string() : "saved pack has the wrong size";
+                }});
+        }
+        if (wanted(load)) {
+            benchmarks.push_back({load, tiles, bytes,
+                [&data] {
+                    const std::string content = readFile(data.path);
+                    data.decodedLevels = 0;
+                    data.failedLevels = 0;
+                    const auto count = [&data](const rle::Error& error) { ++(error ? data.failedLevels : data.decodedLevels); };
+                    if (data.binary) {
+                        rlb::PackReader reader;
+                        if (reader.open(content)) return;
+                        for (uint32_t i = 0; i < reader.count(); ++i) count(reader.decode(i, data.decoded));
+                        return;
+                    }
+                    std::string text;
+                    for (const rle::PackRecord& record : rle::scanPack(content)) {
+                        const std::string_view bytes = std::string_view(content).substr(record.offset, record.length);
+                        count(rle::decode(rle::recordText(bytes, text), data.decoded));
+                    }
+                },
+                [&data]() -> std::string {
+                    if (data.failedLevels > 0) return std::to_string(data.failedLevels) + " levels failed to decode";
+                    if (data.decodedLevels != data.levels.size()) return "wrong number of levels";
+                    return sameTiles(data.levels.back(), data.decoded) ? std::string() : "last level differs from the original";
+                }});
+        }
+        if (wanted(index)) {
+            benchmarks.push_back({index, tiles, bytes,
+                [&data] {
+                    data.records = indexPack(data.content);
+                    data.names.clear();
+                    data.names.reserve(data.records.size());
+                    for (const rle::PackRecord& record : data.records) data.names.push_back(levelName(record.number));
+                },
+                [&data]() -> std::string {
+                    if (data.names.size() != data.levels.size()) return "wrong number of levels";
+                    return data.names.back() == levelName(static_cast<int>(data.levels.size())) ? std::string()
+                                                                                               : "wrong level numbers";
+                }});
+        }
+    }
+}
+
+Result measure(const Options& options, const Benchmark& benchmark) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> samples;
+    double total = 0;
+    while (samples.size() < minIterations || total < options.minTime) {
+        const Clock::time_point start = Clock::now();
+        benchmark.run();
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        samples.push_back(seconds);
+        total += seconds;
+    }
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    Result result;
+    result.name = benchmark.name;
+    result.iterations = static_cast<int>(samples.size());
+    result.seconds = samples[samples.size() / 2];
+    result.tiles = benchmark.tiles;
+    result.bytes = benchmark.bytes;
+    return result;
+}
+
+bool readBaseline(const std::string& path, std::map<std::string, double>& baseline) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string name;
+        double tilesPerSecond = 0;
+        if (fields >> name >> tilesPerSecond) baseline[name] = tilesPerSecond;
+    }
+    return true;
+}
+
+bool writeBaseline(const std::string& path, const std::vector<Result>& results) {
+    std::ofstream file(path, std::ios::trunc);
+    file << "# level-bench baseline: benchmark tiles-per-second\n";
+    char line[256];
+    for (const Result& result : results) {
+        std::snprintf(line, sizeof(line), "%s %.0f\n", result.name.c_str(), result.tilesPerSecond());
+        file << line;
+    }
+    return bool(file);
+}
+
+void printText(const std::vector<Result>& results) {
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-36s %6s %12s %10s %12s %s\n", "benchmark", "runs", "median ms", "MB/s",
+                  "Mtiles/s", "vs baseline");
+    std::cout << line;
+    for (const Result& result : results) {
+        std::string change;
+        if (result.baseline > 0) {
+            char percent[64];
+            std::snprintf(percent, sizeof(percent), "%+.1f%%%s",
+                          (result.tilesPerSecond() / result.baseline - 1) * 100, result.regressed ? " REGRESSED" : "");
+            change = percent;
+        }
+        std::snprintf(line, sizeof(line), "%-36s %6d %12.3f %10.1f %12.2f %s\n", result.name.c_str(),
+                      result.iterations, result.seconds * 1e3, result.megabytesPerSecond(),
+                      result.tilesPerSecond() / 1e6, change.c_str());
+        std::cout << line;
+    }
+}
+
+void printJson(const Options& options, const std::vector<Result>& results) {
+    std::string out = "{\"seed\":" + std::to_string(options.seed) + ",\"benchmarks\":[";
+    size_t regressions = 0;
+    char number[64];
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        if (i > 0) out += ',';
+        out += "{\"name\":\"" + result.name + "\",\"iterations\":" + std::to_string(result.iterations);
+        std::snprintf(number, sizeof(number), "%.9f", result.seconds);
+        out += ",\"seconds\":" + std::string(number) + ",\"tiles\":" + std::to_string(result.tiles)
+             + ",\"bytes\":" + std::to_string(result.bytes);
+        std::snprintf(number, sizeof(number), "%.3f", result.megabytesPerSecond());
+        out += ",\"mbPerSecond\":" + std::string(number);
+        std::snprintf(number, sizeof(number), "%.0f", result.tilesPerSecond());
+        out += ",\"tilesPerSecond\":" + std::string(number);
+        if (result.baseline > 0) {
+            std::snprintf(number, sizeof(number), "%.0f", result.baseline);
+            out += ",\"baselineTilesPerSecond\":" + std::string(number) + ",\"regressed\":"
+                 + (result.regressed ? "true" : "false");
+        }
+        out += '}';
+        if (result.regressed) ++regressions;
+    }
+    out += "],\"regressions\":" + std::to_string(regressions) + "}\n";
+    std::cout << out;
+}
+
+int usage(const char* message) {
+    if (message) std::cerr << "level-bench: " << message << '\n';
+    std::cerr << "usage: level-bench [--seed N] [--quick] [--filter TEXT] [--min-time SECONDS] [--json]\n"
+                 "                   [--baseline FILE [--threshold PERCENT]] [--write-baseline FILE]\n";
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (argument == "--json") options.json = true;
+        else if (argument == "--quick") options.quick = true;
+        else if (argument == "--seed" && hasValue) options.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (argument == "--filter" && hasValue) options.filter = argv[++i];
+        else if (argument == "--min-time" && hasValue) options.minTime = std::max(0.0, std::atof(argv[++i]));
+        else if (argument == "--threshold" && hasValue) options.threshold = std::max(0.0, std::atof(argv[++i]));
+        else if (argument == "--baseline" && hasValue) options.baselinePath = argv[++i];
+        else if (argument == "--write-baseline" && hasValue) options.writeBaselinePath = argv[++i];
+        else return usage(("unknown option " + argument).c_str());
+    }
+
+    std::map<std::string, double> baseline;
+    if (!options.baselinePath.empty() && !readBaseline(options.baselinePath, baseline))
+        return usage(("unable to read " + options.baselinePath).c_str());
+
+    std::error_code error;
+    const fs::path directory = fs::temp_directory_path(error) / ("level-bench-" + std::to_string(std::random_device()()));
+    fs::create_directories(directory, error);
+    if (error) return usage(("unable to create " + directory.string()).c_str());
+
+    // --quick keeps every shape but shrinks the largest inputs, for smoke runs.
+    const int largeSize = options.quick ? 1024 : 4096;
+    const size_t packLevels = options.quick ? 10000 : 100000;
+    std::vector<Benchmark> benchmarks;
+    std::vector<std::unique_ptr<CodecCase>> codecCases;
+    std::vector<std::unique_ptr<PackCase>> packCases;
+    for (const levelgen::Pattern pattern : {levelgen::Pattern::Noise, levelgen::Pattern::Alternating, levelgen::Pattern::Corridors}) {
+        for (const int size : {256, largeSize}) addCodecBenchmarks(benchmarks, codecCases, options, pattern, size);
+    }
+    addPackBenchmarks(benchmarks, packCases, options, directory, packLevels);
+
+    std::vector<Result> results;
+    bool failed = false;
+    for (const Benchmark& benchmark : benchmarks) {
+        Result result = measure(options, benchmark);
+        if (const std::string problem = benchmark.verify(); !problem.empty()) {
+            std::cerr << "level-bench: " << benchmark.name << ": " << problem << '\n';
+            failed = true;
+        }
+        const auto line = baseline.find(result.name);
+        if (line != baseline.end()) {
+            result.baseline = line->second;
+            result.regressed = result.tilesPerSecond() < line->second * (1 - options.threshold / 100);
+            failed = failed || result.regressed;
+        }
+        results.push_back(result);
+    }
+    fs::remove_all(directory, error);
+
+    if (options.json) printJson(options, results);
+    else printText(results);
+    if (!options.writeBaselinePath.empty() && !writeBaseline(options.writeBaselinePath, results)) {
+        std::cerr << "level-bench: unable to write " << options.writeBaselinePath << '\n';
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
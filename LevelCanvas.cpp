@@ -0,0 +1,425 @@
+#include "LevelCanvas.h"
+
+#include <QElapsedTimer>
+#include <QFontDatabase>
+#include <QLabel>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QScreen>
+#include <QScrollBar>
+#include <cmath>
+#include "Trace.h"
+
+LevelCanvas::LevelCanvas(const TileIconManager* icons, QWidget *parent)
+    : QAbstractScrollArea(parent), icons(icons), tileMap(20, 20), mipmap(icons->colors())
+{
+    viewport()->setAttribute(Qt::WA_OpaquePaintEvent);
+    viewport()->setMouseTracking(false);
+    updateScrollBars();
+
+    frameTimer.setSingleShot(true);
+    connect(&frameTimer, &QTimer::timeout, this, &LevelCanvas::flushDirtyCells);
+}
+
+void LevelCanvas::setTiles(TileMap map) {
+    tileMap = std::move(map);
+    updateScrollBars();
+    tilesReplaced();
+}
+
+void LevelCanvas::resizeTiles(int rows, int columns) {
+    tileMap.resize(rows, columns);
+    updateScrollBars();
+    tilesReplaced();
+}
+
+void LevelCanvas::fillTiles(char tile) {
+    tileMap.fill(tile);
+    tilesReplaced();
+}
+
+void LevelCanvas::tilesReplaced() {
+    mipmap.invalidate();
+    dirtyCells = QRect();
+    viewport()->update();
+    tilesChanged(QRect(0, 0, tileMap.columns(), tileMap.rows()));
+}
+
+void LevelCanvas::tilesEdited(const QRect& cells) {
+    if (cells.isEmpty()) return;
+    mipmap.update(tileMap, cells);
+    viewport()->update(viewTransform().mapRect(QRectF(cells)).toAlignedRect().adjusted(-1, -1, 1, 1));
+    tilesChanged(cells);
+}
+
+void LevelCanvas::updateCells(const QRect& cells) {
+    if (cells.isEmpty()) return;
+    viewport()->update(viewTransform().mapRect(QRectF(cells)).toAlignedRect().adjusted(-2, -2, 2, 2));
+}
+
+void LevelCanvas::setToolPreview(const QRect& cells) {
+    if (cells == toolPreview) return;
+    updateCells(toolPreview);
+    updateCells(cells);
+    toolPreview = cells;
+}
+
+void LevelCanvas::setSelection(const QRect& cells) {
+    if (cells == selection) return;
+    updateCells(selection);
+    updateCells(cells);
+    selection = cells;
+}
+
+QRect LevelCanvas::floatingRect() const {
+    return QRect(floatingOrigin, QSize(floatingTiles.columns(), floatingTiles.rows()));
+}
+
+void LevelCanvas::setFloatingTiles(TileMap tiles, const QPoint& origin) {
+    updateCells(floatingRect());
+    floatingTiles = std::move(tiles);
+    floatingOrigin = origin;
+    floatingColors = QImage();
+    if (!floatingTiles.isEmpty()) {
+        floatingColors = QImage(floatingTiles.columns(), floatingTiles.rows(), QImage::Format_RGB32);
+        std::vector<char> line(static_cast<size_t>(floatingTiles.columns()));
+        for (int row = 0; row < floatingTiles.rows(); ++row) {
+            floatingTiles.readRow(row, 0, floatingTiles.columns(), line.data());
+            auto* pixels = reinterpret_cast<QRgb*>(floatingColors.scanLine(row));
+            for (int col = 0; col < floatingTiles.columns(); ++col) pixels[col] = icons->color(line[col]);
+        }
+    }
+    updateCells(floatingRect());
+}
+
+void LevelCanvas::moveFloatingTiles(const QPoint& origin) {
+    if (origin == floatingOrigin) return;
+    updateCells(floatingRect());
+    floatingOrigin = origin;
+    updateCells(floatingRect());
+}
+
+void LevelCanvas::setOverlay(QImage image) {
+    if (image.isNull() && overlay.isNull()) return;
+    overlay = std::move(image);
+    viewport()->update();
+}
+
+void LevelCanvas::tilesChanged(const QRect& cells) {
+    for (const auto& handler : tilesChangedHandlers) handler(cells);
+}
+
+void LevelCanvas::viewChanged() {
+    if (viewChangedHandler) viewChangedHandler();
+}
+
+const TileMipmap& LevelCanvas::colorMipmap() const {
+    if (!mipmap.isValid()) mipmap.build(tileMap);
+    return mipmap;
+}
+
+void LevelCanvas::setTile(int row, int col, char tile) {
+    if (!tileMap.contains(row, col)) return;
+    tileMap.set(row, col, tile);
+    mipmap.update(tileMap, row, col);
+    dirtyCells |= QRect(col, row, 1, 1);
+    if (frameTimer.isActive()) return;
+    const qreal refreshRate = screen() ? screen()->refreshRate() : 60.0;
+    frameTimer.start(std::max(1, qRound(1000.0 / std::max<qreal>(refreshRate, 1.0))));
+}
+
+void LevelCanvas::flushDirtyCells() {
+    if (dirtyCells.isEmpty()) return;
+    const QRect area = viewTransform().mapRect(QRectF(dirtyCells)).toAlignedRect().adjusted(-1, -1, 1, 1);
+    const QRect cells = dirtyCells;
+    dirtyCells = QRect();
+    viewport()->update(area);
+    tilesChanged(cells);
+}
+
+QPoint LevelCanvas::cellAt(const QPoint& position) const {
+    const QPointF cell = viewTransform().inverted().map(QPointF(position));
+    return {static_cast<int>(std::floor(cell.x())), static_cast<int>(std::floor(cell.y()))};
+}
+
+QTransform LevelCanvas::viewTransform() const {
+    return QTransform(scale, 0, 0, scale, -horizontalScrollBar()->value(), -verticalScrollBar()->value());
+}
+
+QRectF LevelCanvas::visibleCells() const {
+    return viewTransform().inverted().mapRect(QRectF(viewport()->rect()));
+}
+
+void LevelCanvas::centerOn(const QPointF& cell) {
+    const QPoint center = viewport()->rect().center();
+    horizontalScrollBar()->setValue(qRound(cell.x() * scale - center.x()));
+    verticalScrollBar()->setValue(qRound(cell.y() * scale - center.y()));
+}
+
+void LevelCanvas::setZoom(qreal zoom, const QPoint& anchor) {
+    zoom = std::clamp(zoom, minZoom, maxZoom);
+    if (zoom == scale) return;
+    const QPointF cell = viewTransform().inverted().map(QPointF(anchor));
+    scale = zoom;
+    updateScrollBars();
+    horizontalScrollBar()->setValue(qRound(cell.x() * scale - anchor.x()));
+    verticalScrollBar()->setValue(qRound(cell.y() * scale - anchor.y()));
+    viewport()->update();
+    viewChanged();
+}
+
+void LevelCanvas::zoomBy(qreal factor) {
+    setZoom(scale * factor, viewport()->rect().center());
+}
+
+void LevelCanvas::fitToView() {
+    if (tileMap.isEmpty()) return;
+    const QSize area = viewport()->size();
+    scale = std::clamp(std::min(qreal(area.width()) / tileMap.columns(), qreal(area.height()) / tileMap.rows()), minZoom, maxZoom);
+    updateScrollBars();
+    horizontalScrollBar()->setValue(0);
+    verticalScrollBar()->setValue(0);
+    viewport()->update();
+    viewChanged();
+}
+
+void LevelCanvas::paintEvent(QPaintEvent *event) {
+    TRACE_SCOPE("LevelCanvas::paintEvent");
+    QElapsedTimer paintClock;
+    paintClock.start();
+    paintedTiles = 0;
+    {
+        QPainter painter(viewport());
+        paintLevel(painter, event->rect());
+    }
+    const qint64 nanoseconds = paintClock.nsecsElapsed();
+    if (perfLabel) updatePerfOverlay(nanoseconds);
+    if (paintTimeHandler) paintTimeHandler(nanoseconds);
+}
+
+void LevelCanvas::paintLevel(QPainter& painter, const QRect& region) {
+    painter.fillRect(region, palette().base());
+    if (tileMap.isEmpty()) return;
+
+    const QRectF area = viewTransform().inverted().mapRect(QRectF(region));
+    const int firstRow = std::max(static_cast<int>(std::floor(area.top())), 0);
+    const int lastRow = std::min(static_cast<int>(std::ceil(area.bottom())) - 1, tileMap.rows() - 1);
+    const int firstCol = std::max(static_cast<int>(std::floor(area.left())), 0);
+    const int lastCol = std::min(static_cast<int>(std::ceil(area.right())) - 1, tileMap.columns() - 1);
+    if (firstRow > lastRow || firstCol > lastCol) return;
+
+    const QRect cells(QPoint(firstCol, firstRow), QPoint(lastCol, lastRow));
+    if (scale < lodZoom) paintColors(painter, cells);
+    else {
+        paintSprites(painter, cells, tileMap, QPoint());
+        if (scale >= gridZoom) paintGrid(painter, cells);
+    }
+
+    // An overlay computed for other dimensions is stale until its replacement arrives.
+    if (overlay.size() == QSize(tileMap.columns(), tileMap.rows())) {
+        painter.setTransform(viewTransform());
+        painter.setClipping(false);
+        painter.drawImage(QRectF(cells), overlay, cells);
+    }
+    if (!floatingTiles.isEmpty()) paintFloatingTiles(painter, cells);
+
+    if (!toolPreview.isEmpty()) {
+        painter.resetTransform();
+        painter.setClipping(false);
+        const QRectF preview = viewTransform().mapRect(QRectF(toolPreview));
+        painter.fillRect(preview, QColor(255, 255, 0, 60));
+        painter.setPen(QPen(Qt::yellow, 2));
+        painter.drawRect(preview);
+    }
+    if (!selection.isEmpty()) {
+        painter.resetTransform();
+        painter.setClipping(false);
+        const QRectF outline = viewTransform().mapRect(QRectF(selection));
+        painter.setPen(QPen(Qt::white, 1));
+        painter.drawRect(outline);
+        painter.setPen(QPen(Qt::black, 1, Qt::DashLine));
+        painter.drawRect(outline);
+    }
+}
+
+void LevelCanvas::paintSprites(QPainter& painter, const QRect& cells, const TileMap& tiles, const QPoint& origin) {
+    TRACE_SCOPE("LevelCanvas::paintSprites");
+    paintedTiles += static_cast<qint64>(cells.width()) * cells.height();
+    // Cell edges are rounded to whole pixels so neighbouring sprites and grid lines line up.
+    const int dx = horizontalScrollBar()->value();
+    const int dy = verticalScrollBar()->value();
+    const auto edgeX = [this, dx](int col) { return qRound(col * scale) - dx; };
+    const auto edgeY = [this, dy](int row) { return qRound(row * scale) - dy; };
+    const int spriteSize = static_cast<int>(scale * 0.95);
+    for (int row = cells.top(); row <= cells.bottom(); ++row) {
+        const int top = edgeY(row);
+        const int height = edgeY(row + 1) - top;
+        for (int col = cells.left(); col <= cells.right(); ++col) {
+            const QPixmap& pixmap = icons->pixmap(tiles.at(row - origin.y(), col - origin.x()), spriteSize);
+            if (pixmap.isNull()) continue;
+            const int left = edgeX(col);
+            const int width = edgeX(col + 1) - left;
+            painter.drawPixmap(left + (width - pixmap.width()) / 2, top + (height - pixmap.height()) / 2, pixmap);
+        }
+    }
+}
+
+void LevelCanvas::paintGrid(QPainter& painter, const QRect& cells) {
+    const int dx = horizontalScrollBar()->value();
+    const int dy = verticalScrollBar()->value();
+    const auto edgeX = [this, dx](int col) { return qRound(col * scale) - dx; };
+    const auto edgeY = [this, dy](int row) { return qRound(row * scale) - dy; };
+    painter.setPen(palette().mid().color());
+    const int left = edgeX(cells.left());
+    const int right = edgeX(cells.right() + 1);
+    const int top = edgeY(cells.top());
+    const int bottom = edgeY(cells.bottom() + 1);
+    for (int row = cells.top(); row <= cells.bottom() + 1; ++row) painter.drawLine(left, edgeY(row), right, edgeY(row));
+    for (int col = cells.left(); col <= cells.right() + 1; ++col) painter.drawLine(edgeX(col), top, edgeX(col), bottom);
+}
+
+// Clipped to the level, since that is all a paste can change.
+void LevelCanvas::paintFloatingTiles(QPainter& painter, const QRect& cells) {
+    const QRect area = floatingRect() & cells;
+    if (area.isEmpty()) return;
+    painter.resetTransform();
+    painter.setClipping(false);
+    painter.setOpacity(0.75);
+    if (scale >= lodZoom) paintSprites(painter, area, floatingTiles, floatingOrigin);
+    else {
+        painter.setTransform(viewTransform());
+        painter.drawImage(QRectF(area), floatingColors, area.translated(-floatingOrigin));
+        painter.resetTransform();
+    }
+    painter.setOpacity(1);
+    painter.setPen(QPen(Qt::cyan, 2));
+    painter.drawRect(viewTransform().mapRect(QRectF(floatingRect())));
+}
+
+void LevelCanvas::paintColors(QPainter& painter, const QRect& cells) {
+    TRACE_SCOPE("LevelCanvas::paintColors");
+    const TileMipmap& colors = colorMipmap();
+    if (colors.levelCount() == 0) return;
+
+    const int index = colors.levelFor(scale);
+    const int block = 1 << index;
+    const QRect source(QPoint(cells.left() / block, cells.top() / block), QPoint(cells.right() / block, cells.bottom() / block));
+    const QRectF target(source.x() * block, source.y() * block, source.width() * block, source.height() * block);
+    paintedTiles += static_cast<qint64>(source.width()) * source.height();
+
+    painter.setTransform(viewTransform());
+    painter.setClipRect(QRectF(0, 0, tileMap.columns(), tileMap.rows()));
+    painter.drawImage(target, colors.level(index), source);
+}
+
+void LevelCanvas::resizeEvent(QResizeEvent *event) {
+    TRACE_SCOPE("LevelCanvas::resizeEvent");
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+    viewChanged();
+}
+
+void LevelCanvas::scrollContentsBy(int, int) {
+    viewport()->update();
+    viewChanged();
+}
+
+void LevelCanvas::wheelEvent(QWheelEvent *event) {
+    if (!(event->modifiers() & Qt::ControlModifier)) {
+        QAbstractScrollArea::wheelEvent(event);
+        return;
+    }
+    setZoom(scale * std::pow(1.0015, event->angleDelta().y()), event->position().toPoint());
+    event->accept();
+}
+
+void LevelCanvas::mousePressEvent(QMouseEvent *event) {
+    if (event->button() != Qt::MiddleButton) {
+        QAbstractScrollArea::mousePressEvent(event);
+        return;
+    }
+    panning = true;
+    panOrigin = event->pos();
+    viewport()->setCursor(Qt::ClosedHandCursor);
+    event->accept();
+}
+
+void LevelCanvas::mouseMoveEvent(QMouseEvent *event) {
+    if (!panning) {
+        QAbstractScrollArea::mouseMoveEvent(event);
+        return;
+    }
+    const QPoint delta = event->pos() - panOrigin;
+    panOrigin = event->pos();
+    horizontalScrollBar()->setValue(horizontalScrollBar()->value() - delta.x());
+    verticalScrollBar()->setValue(verticalScrollBar()->value() - delta.y());
+    event->accept();
+}
+
+void LevelCanvas::mouseReleaseEvent(QMouseEvent *event) {
+    if (event->button() != Qt::MiddleButton || !panning) {
+        QAbstractScrollArea::mouseReleaseEvent(event);
+        return;
+    }
+    panning = false;
+    viewport()->unsetCursor();
+    event->accept();
+}
+
+void LevelCanvas::setPerfOverlayVisible(bool visible) {
+    if (visible == (perfLabel != nullptr)) return;
+    if (!visible) {
+        delete perfLabel;
+        perfLabel = nullptr;
+        return;
+    }
+    // An opaque child, so refreshing its text does not repaint the canvas under it.
+    perfLabel = new QLabel(viewport());
+    perfLabel->setAutoFillBackground(true);
+    perfLabel->setAttribute(Qt::WA_TransparentForMouseEvents);
+    QPalette colors = perfLabel->palette();
+    colors.setColor(QPalette::Window, QColor(20, 20, 20));
+    colors.setColor(QPalette::WindowText, Qt::white);
+    perfLabel->setPalette(colors);
+    perfLabel->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    perfLabel->setMargin(4);
+    perfLabel->move(8, 8);
+    perfLabel->show();
+    frameClock.invalidate();
+    perfRefresh.invalidate();
+    viewport()->update();
+}
+
+size_t LevelCanvas::levelMemoryUsage() const {
+    return tileMap.memoryUsage() + mipmap.memoryUsage() + floatingTiles.memoryUsage()
+         + static_cast<size_t>(overlay.sizeInBytes() + floatingColors.sizeInBytes());
+}
+
+void LevelCanvas::updatePerfOverlay(qint64 paintNanoseconds) {
+    // Frame time is the gap between paints, smoothed; it only means something while repainting continuously.
+    const qreal paintMs = paintNanoseconds / 1e6;
+    if (frameClock.isValid()) {
+        const qreal frameMs = frameClock.nsecsElapsed() / 1e6;
+        averageFrameMs = averageFrameMs > 0 ? averageFrameMs * 0.9 + frameMs * 0.1 : frameMs;
+    }
+    frameClock.start();
+    averagePaintMs = averagePaintMs > 0 ? averagePaintMs * 0.9 + paintMs * 0.1 : paintMs;
+    if (perfRefresh.isValid() && perfRefresh.elapsed() < 250) return;
+    perfRefresh.start();
+    perfLabel->setText(QString("frame %1 ms\npaint %2 ms (last %3)\ntiles drawn %4\nlevel data %5 KB")
+                           .arg(averageFrameMs, 0, 'f', 2).arg(averagePaintMs, 0, 'f', 2).arg(paintMs, 0, 'f', 2)
+                           .arg(paintedTiles).arg(levelMemoryUsage() / 1024));
+    perfLabel->adjustSize();
+}
+
+void LevelCanvas::updateScrollBars() {
+    const QSize area = viewport()->size();
+    const int width = static_cast<int>(std::ceil(tileMap.columns() * scale)) + 1;
+    const int height = static_cast<int>(std::ceil(tileMap.rows() * scale)) + 1;
+    horizontalScrollBar()->setRange(0, std::max(width - area.width(), 0));
+    verticalScrollBar()->setRange(0, std::max(height - area.height(), 0));
+    horizontalScrollBar()->setPageStep(area.width());
+    verticalScrollBar()->setPageStep(area.height());
+    horizontalScrollBar()->setSingleStep(std::max(qRound(scale), 1));
+    verticalScrollBar()->setSingleStep(std::max(qRound(scale), 1));
+}
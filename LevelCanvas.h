@@ -0,0 +1,136 @@
+#ifndef LEVELCANVAS_H
+#define LEVELCANVAS_H
+
+#include <QAbstractScrollArea>
+#include <QElapsedTimer>
+#include <QLabel>
+#include <QTimer>
+#include <QTransform>
+#include <functional>
+#include <type_traits>
+#include <vector>
+#include "TileIconManager.h"
+#include "TileMap.h"
+#include "TileMipmap.h"
+
+// Scrollable, zoomable view of a tile map. Cells are mapped to the viewport by a
+// scale-and-translate transform; above lodZoom pixels per cell they are drawn as
+// sprites, below it as one color per tile or per block of tiles from a TileMipmap.
+class LevelCanvas : public QAbstractScrollArea
+{
+public:
+    static constexpr qreal minZoom = 1.0 / 32;
+    static constexpr qreal maxZoom = 128;
+    static constexpr qreal lodZoom = 6;
+    static constexpr qreal gridZoom = 12;
+
+    explicit LevelCanvas(const TileIconManager* icons, QWidget *parent = nullptr);
+
+    const TileMap& tiles() const { return tileMap; }
+    void setTiles(TileMap map);
+    void resizeTiles(int rows, int columns);
+    void fillTiles(char tile);
+    // Changes are batched and repainted as one dirty rectangle at the next display frame.
+    void setTile(int row, int col, char tile);
+    // Lets edit change any number of tiles in place and repaints once afterwards. An
+    // edit that returns the QRect of cells it touched only repaints that area.
+    template <typename Edit>
+    void editTiles(Edit&& edit) {
+        if constexpr (std::is_void_v<std::invoke_result_t<Edit, TileMap&>>) {
+            edit(tileMap);
+            tilesReplaced();
+        }
+        else tilesEdited(edit(tileMap));
+    }
+    // Outline drawn over the cells a tool is about to change; an empty rect hides it.
+    void setToolPreview(const QRect& cells);
+    // Image with one pixel per cell drawn over the tiles; a null image hides it.
+    void setOverlay(QImage image);
+    // Dashed outline around the selected cells; an empty rect hides it.
+    void setSelection(const QRect& cells);
+    // Tiles drawn translucently over the level with their first cell at origin, as a
+    // preview of a paste or move. An empty map hides them.
+    void setFloatingTiles(TileMap tiles, const QPoint& origin);
+    void moveFloatingTiles(const QPoint& origin);
+    char tileAt(int row, int col) const { return tileMap.at(row, col); }
+
+    int rowCount() const { return tileMap.rows(); }
+    int columnCount() const { return tileMap.columns(); }
+    // Cell under a viewport position, which may lie outside the level.
+    QPoint cellAt(const QPoint& position) const;
+
+    qreal zoom() const { return scale; }
+    // Pixels per cell; the cell under anchor (viewport coordinates) stays in place.
+    void setZoom(qreal zoom, const QPoint& anchor);
+    void zoomBy(qreal factor);
+    void fitToView();
+    // Maps cell coordinates to viewport pixels.
+    QTransform viewTransform() const;
+    QRectF visibleCells() const;
+    void centerOn(const QPointF& cell);
+
+    // Color pyramid of the current tiles, rebuilt here if a bulk edit invalidated it.
+    const TileMipmap& colorMipmap() const;
+    // Called with the cells that changed (once per frame for single-tile edits), and
+    // whenever the visible part of the level moves or is rescaled.
+    void addTilesChangedHandler(std::function<void(const QRect&)> handler) { tilesChangedHandlers.push_back(std::move(handler)); }
+    void setViewChangedHandler(std::function<void()> handler) { viewChangedHandler = std::move(handler); }
+    // Called after every paint of the viewport with the time the paint took.
+    void setPaintTimeHandler(std::function<void(qint64 nanoseconds)> handler) { paintTimeHandler = std::move(handler); }
+
+    // Frame time, paint time, tiles drawn and memory held by the level, in a corner of the view.
+    void setPerfOverlayVisible(bool visible);
+    bool isPerfOverlayVisible() const { return perfLabel != nullptr; }
+    size_t levelMemoryUsage() const;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+private:
+    void paintLevel(QPainter& painter, const QRect& region);
+    void paintSprites(QPainter& painter, const QRect& cells, const TileMap& tiles, const QPoint& origin);
+    void paintGrid(QPainter& painter, const QRect& cells);
+    void paintColors(QPainter& painter, const QRect& cells);
+    void paintFloatingTiles(QPainter& painter, const QRect& cells);
+    void updateCells(const QRect& cells);
+    QRect floatingRect() const;
+    void updatePerfOverlay(qint64 paintNanoseconds);
+    void updateScrollBars();
+    void flushDirtyCells();
+    void tilesReplaced();
+    void tilesEdited(const QRect& cells);
+    void tilesChanged(const QRect& cells);
+    void viewChanged();
+
+    const TileIconManager* icons;
+    TileMap tileMap;
+    mutable TileMipmap mipmap;
+    qreal scale = 32;
+    QRect dirtyCells;
+    QRect toolPreview;
+    QImage overlay;
+    QRect selection;
+    TileMap floatingTiles;
+    QImage floatingColors;
+    QPoint floatingOrigin;
+    QTimer frameTimer;
+    bool panning = false;
+    QPoint panOrigin;
+    std::vector<std::function<void(const QRect&)>> tilesChangedHandlers;
+    std::function<void()> viewChangedHandler;
+    std::function<void(qint64)> paintTimeHandler;
+    QLabel* perfLabel = nullptr;
+    QElapsedTimer frameClock;
+    QElapsedTimer perfRefresh;
+    qreal averageFrameMs = 0;
+    qreal averagePaintMs = 0;
+    qint64 paintedTiles = 0;
+};
+
+#endif // LEVELCANVAS_H
@@ -0,0 +1,559 @@
+// level-cli: batch validation, statistics and conversion of level packs without a GUI.
+//
+//   level-cli validate [options] <pack>...
+//   level-cli stats    [options] <pack>...
+//   level-cli reencode [options] <pack>...            rewrite in canonical form
+//   level-cli convert  --to rll|rlb [--shared-rows] [options] <pack>...
+//   level-cli diff     [--json] <before> <after>
+//   level-cli merge    [--json] --output FILE <base> <ours> <theirs>
+//
+// Options: --json, --jobs N, --output DIR, --in-place. --shared-rows stores every
+// distinct row once for the whole .rlb pack (see RlbFormat.h); reencode keeps the
+// shared rows of packs that have them.
+// Exit code 0 when every level decoded, 1 when any file or level failed, 2 on usage errors.
+// diff exits with 1 when the packs differ and merge with 1 when there were conflicts;
+// the merged pack is written as .rll text either way.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "PackDiff.h"
+#include "RleCodec.h"
+#include "RlbFormat.h"
+#include "WorkStealingPool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t levelsPerTask = 64;
+
+enum class Command {
+    Validate,
+    Stats,
+    Reencode,
+    Convert,
+    Diff,
+    Merge
+};
+
+struct Options {
+    Command command = Command::Validate;
+    std::vector<std::string> files;
+    unsigned jobs = 0;
+    bool json = false;
+    bool inPlace = false;
+    bool sharedRows = false;
+    std::string output;  // the output directory, or the merged pack for merge
+    std::string format;
+};
+
+struct LevelResult {
+    int number = 0;
+    rle::Error error;
+    size_t fileOffset = 0;
+    int rows = 0;
+    int columns = 0;
+    size_t runs = 0;
+    size_t textBytes = 0;
+    size_t binaryBytes = 0;
+    std::array<uint32_t, 256> tileCounts{};
+    std::string output;
+};
+
+struct FileJob {
+    std::string path;
+    std::string content;
+    bool binary = false;
+    // Set when the .rlb pack has shared rows; views into content.
+    bool sharedRows = false;
+    rlb::RowDictionary rows;
+    std::string ioError;
+    std::string outputPath;
+    std::vector<rle::PackRecord> records;
+    std::vector<LevelResult> levels;
+    std::atomic<size_t> remaining{0};
+
+    bool failed() const {
+        if (!ioError.empty()) return true;
+        return std::any_of(levels.begin(), levels.end(), [](const LevelResult& level) { return bool(level.error); });
+    }
+};
+
+const char* codeName(rle::ErrorCode code) {
+    switch (code) {
+        case rle::ErrorCode::None:          return "None";
+        case rle::ErrorCode::MissingTile:   return "MissingTile";
+        case rle::ErrorCode::RaggedRow:     return "RaggedRow";
+        case rle::ErrorCode::CountOverflow: return "CountOverflow";
+        case rle::ErrorCode::LevelTooLarge: return "LevelTooLarge";
+        case rle::ErrorCode::Truncated:     return "Truncated";
+        case rle::ErrorCode::BadFormat:     return "BadFormat";
+    }
+    return "Unknown";
+}
+
+std::string jsonString(std::string_view text) {
+    std::string out = "\"";
+    for (const char c : text) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+                    out += escaped;
+                }
+                else out += c;
+        }
+    }
+    return out + '"';
+}
+
+bool writesOutput(const Options& options) {
+    return options.command == Command::Reencode || options.command == Command::Convert;
+}
+
+bool targetIsBinary(const Options& options, const FileJob& job) {
+    return options.command == Command::Convert ? options.format == "rlb" : job.binary;
+}
+
+std::string outputPathFor(const Options& options, const FileJob& job) {
+    fs::path path = job.path;
+    if (options.command == Command::Convert) path.replace_extension(options.format);
+    if (!options.inPlace) path = fs::path(options.output) / path.filename();
+    return path.string();
+}
+
+// Decodes one level and fills in everything the chosen command reports or writes.
+void processLevel(const Options& options, FileJob& job, size_t index, rle::Level& level, std::string& scratch) {
+    LevelResult& result = job.levels[index];
+    const rle::PackRecord& record = job.records[index];
+    const std::string_view bytes = std::string_view(job.content).substr(record.offset, record.length);
+    result.number = record.number;
+
+    if (job.binary) {
+        result.error = rlb::decodeLevel(bytes, level, job.sharedRows ? &job.rows : nullptr);
+        result.fileOffset = record.offset + result.error.offset;
+    }
+    else {
+        result.error = rle::decode(rle::recordText(bytes, scratch), level);
+        result.fileOffset = record.offset + rle::recordOffset(bytes, result.error.offset);
+    }
+    if (result.error) return;
+
+    result.rows = level.rows;
+    result.columns = level.columns;
+    if (options.command == Command::Stats) {
+        std::string encoded;
+        rle::encode(level, encoded);
+        result.textBytes = encoded.size();
+        encoded.clear();
+        rlb::encodeLevel(level, encoded);
+        result.binaryBytes = encoded.size();
+        for (int row = 0; row < level.rows; ++row) {
+            const char* tiles = level.tiles.data() + static_cast<size_t>(row) * level.columns;
+            for (int column = 0; column < level.columns; ++column) {
+                ++result.tileCounts[static_cast<unsigned char>(tiles[column])];
+                if (column == 0 || tiles[column] != tiles[column - 1]) ++result.runs;
+            }
+        }
+    }
+    else if (writesOutput(options)) {
+        if (targetIsBinary(options, job)) rlb::encodeLevel(level, result.output);
+        else rle::encode(level, result.output);
+    }
+}
+
+// Writes next to path and renames over it, so a failed write never leaves half a
+// pack behind. Returns an error message, empty on success.
+std::string replaceFile(const std::string& path, std::string_view content) {
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+        if (!file) return "unable to write " + temporary;
+    }
+    std::error_code error;
+    fs::rename(temporary, path, error);
+    if (error) {
+        fs::remove(temporary, error);
+        return "unable to replace " + path;
+    }
+    return {};
+}
+
+void writeFile(const Options& options, FileJob& job) {
+    std::string out;
+    if (targetIsBinary(options, job)) {
+        rlb::PackWriter writer(options.command == Command::Convert ? options.sharedRows : job.sharedRows);
+        out.append(rlb::headerSize, '\0');
+        rlb::TableEntry entry;
+        for (const LevelResult& level : job.levels) {
+            if (rle::Error error = writer.addRecord(level.number, level.output, nullptr, out, entry)) {
+                job.ioError = "Level " + std::to_string(level.number) + ": " + rle::describe(error);
+                return;
+            }
+        }
+        char header[rlb::headerSize];
+        writer.finish(out, header);
+        out.replace(0, rlb::headerSize, header, rlb::headerSize);
+    }
+    else {
+        for (const LevelResult& level : job.levels) rle::appendPackRecord(level.number, level.output, out);
+    }
+
+    job.outputPath = outputPathFor(options, job);
+    job.ioError = replaceFile(job.outputPath, out);
+}
+
+void finishFile(const Options& options, FileJob& job) {
+    if (writesOutput(options) && !job.failed()) writeFile(options, job);
+    for (LevelResult& level : job.levels) std::string().swap(level.output);
+    std::string().swap(job.content);
+    job.rows = rlb::RowDictionary();
+}
+
+void processFile(const Options& options, WorkStealingPool& pool, FileJob& job) {
+    {
+        std::ifstream file(job.path, std::ios::binary);
+        if (!file) {
+            job.ioError = "unable to open file";
+            return;
+        }
+        std::ostringstream content;
+        content << file.rdbuf();
+        job.content = content.str();
+    }
+
+    job.binary = rlb::isRlb(job.content);
+    if (job.binary) {
+        rlb::PackReader reader;
+        if (rle::Error error = reader.open(job.content)) {
+            job.ioError = rle::describe(error);
+            return;
+        }
+        if (reader.rows()) {
+            job.sharedRows = true;
+            job.rows = *reader.rows();
+        }
+        job.records.reserve(reader.count());
+        for (uint32_t i = 0; i < reader.count(); ++i) {
+            const rlb::TableEntry entry = reader.entry(i);
+            if (entry.offset > job.content.size() || entry.length > job.content.size() - entry.offset) {
+                job.ioError = "level table points past the end of the file";
+                return;
+            }
+            job.records.push_back({entry.number, static_cast<size_t>(entry.offset), entry.length});
+        }
+    }
+    else job.records = rle::scanPack(job.content);
+
+    job.levels.resize(job.records.size());
+    const size_t tasks = (job.records.size() + levelsPerTask - 1) / levelsPerTask;
+    if (tasks == 0) {
+        finishFile(options, job);
+        return;
+    }
+    job.remaining = tasks;
+    for (size_t task = 0; task < tasks; ++task) {
+        pool.submit([&options, &job, task] {
+            rle::Level level;
+            std::string scratch;
+            const size_t end = std::min(job.records.size(), (task + 1) * levelsPerTask);
+            for (size_t i = task * levelsPerTask; i < end; ++i) processLevel(options, job, i, level, scratch);
+            if (job.remaining.fetch_sub(1) == 1) finishFile(options, job);
+        });
+    }
+}
+
+void printText(const Options& options, const std::vector<std::unique_ptr<FileJob>>& jobs) {
+    size_t levels = 0;
+    size_t failures = 0;
+    for (const auto& job : jobs) {
+        levels += job->levels.size();
+        if (!job->ioError.empty()) {
+            std::cerr << job->path << ": " << job->ioError << '\n';
+            ++failures;
+        }
+        for (const LevelResult& level : job->levels) {
+            if (level.error) {
+                std::cerr << job->path << ':' << level.fileOffset << ": Level " << level.number << ": "
+                          << rle::describe(level.error.code) << " (row " << level.error.row + 1 << ", column "
+                          << level.error.column + 1 << ")\n";
+                ++failures;
+            }
+            else if (options.command == Command::Stats) {
+                std::cout << job->path << ": Level " << level.number << ": " << level.rows << 'x' << level.columns
+                          << ", " << level.runs << " runs, " << level.textBytes << " bytes rll, " << level.binaryBytes
+                          << " bytes rlb\n";
+            }
+        }
+        if (!job->outputPath.empty()) std::cout << job->path << " -> " << job->outputPath << '\n';
+    }
+    std::cout << jobs.size() << " files, " << levels << " levels, " << failures << " failures\n";
+}
+
+void printJson(const Options& options, const std::vector<std::unique_ptr<FileJob>>& jobs) {
+    size_t levels = 0;
+    size_t failedFiles = 0;
+    size_t failedLevels = 0;
+    std::string out = "{\"files\":[";
+    for (size_t f = 0; f < jobs.size(); ++f) {
+        const FileJob& job = *jobs[f];
+        levels += job.levels.size();
+        if (job.failed()) ++failedFiles;
+        if (f > 0) out += ',';
+        out += "{\"path\":" + jsonString(job.path) + ",\"format\":\"" + (job.binary ? "rlb" : "rll") + "\",\"ok\":"
+             + (job.failed() ? "false" : "true") + ",\"levels\":" + std::to_string(job.levels.size());
+        if (!job.ioError.empty()) out += ",\"error\":" + jsonString(job.ioError);
+        if (!job.outputPath.empty()) out += ",\"output\":" + jsonString(job.outputPath);
+
+        out += ",\"failures\":[";
+        bool first = true;
+        for (size_t i = 0; i < job.levels.size(); ++i) {
+            const LevelResult& level = job.levels[i];
+            if (!level.error) continue;
+            ++failedLevels;
+            if (!first) out += ',';
+            first = false;
+            out += "{\"index\":" + std::to_string(i) + ",\"level\":" + std::to_string(level.number) + ",\"code\":\""
+                 + codeName(level.error.code) + "\",\"message\":" + jsonString(rle::describe(level.error.code))
+                 + ",\"offset\":" + std::to_string(level.fileOffset) + ",\"row\":" + std::to_string(level.error.row + 1)
+                 + ",\"column\":" + std::to_string(level.error.column + 1) + '}';
+        }
+        out += ']';
+
+        if (options.command == Command::Stats) {
+            out += ",\"stats\":[";
+            first = true;
+            for (const LevelResult& level : job.levels) {
+                if (level.error) continue;
+                if (!first) out += ',';
+                first = false;
+                out += "{\"level\":" + std::to_string(level.number) + ",\"rows\":" + std::to_string(level.rows)
+                     + ",\"columns\":" + std::to_string(level.columns) + ",\"runs\":" + std::to_string(level.runs)
+                     + ",\"rllBytes\":" + std::to_string(level.textBytes) + ",\"rlbBytes\":"
+                     + std::to_string(level.binaryBytes) + ",\"tiles\":{";
+                bool firstTile = true;
+                for (size_t tile = 0; tile < level.tileCounts.size(); ++tile) {
+                    if (!level.tileCounts[tile]) continue;
+                    if (!firstTile) out += ',';
+                    firstTile = false;
+                    out += jsonString(std::string(1, static_cast<char>(tile))) + ':' + std::to_string(level.tileCounts[tile]);
+                }
+                out += "}}";
+            }
+            out += ']';
+        }
+        out += '}';
+    }
+    out += "],\"summary\":{\"files\":" + std::to_string(jobs.size()) + ",\"levels\":" + std::to_string(levels)
+         + ",\"failedFiles\":" + std::to_string(failedFiles) + ",\"failedLevels\":" + std::to_string(failedLevels) + "}}\n";
+    std::cout << out;
+}
+
+bool loadPackText(const std::string& path, packdiff::PackText& pack) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << path << ": unable to open file\n";
+        return false;
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    std::string error;
+    if (!packdiff::readPack(content.str(), pack, error)) {
+        std::cerr << path << ": " << error << '\n';
+        return false;
+    }
+    return true;
+}
+
+int runDiff(const Options& options) {
+    packdiff::PackText before;
+    packdiff::PackText after;
+    if (!loadPackText(options.files[0], before) || !loadPackText(options.files[1], after)) return 2;
+    const packdiff::PackDiff diff = packdiff::diffPacks(before.levels, after.levels);
+
+    if (options.json) {
+        std::string out = "{\"levels\":[";
+        bool first = true;
+        for (const packdiff::LevelDiff& level : diff.levels) {
+            if (level.change == packdiff::Change::Unchanged) continue;
+            if (!first) out += ',';
+            first = false;
+            out += std::string("{\"change\":\"") + packdiff::changeName(level.change) + '"';
+            if (level.before >= 0) out += ",\"before\":" + std::to_string(level.beforeNumber);
+            if (level.after >= 0) out += ",\"after\":" + std::to_string(level.afterNumber);
+            if (level.change == packdiff::Change::Modified) {
+                out += ",\"changedRows\":[";
+                for (size_t i = 0; i < level.changedRows.size(); ++i)
+                    out += (i > 0 ? "," : "") + std::to_string(level.changedRows[i]);
+                out += std::string("],\"resized\":") + (level.resized ? "true" : "false")
+                     + ",\"linksChanged\":" + (level.linksChanged ? "true" : "false");
+            }
+            out += '}';
+        }
+        out += "],\"summary\":{\"unchanged\":" + std::to_string(diff.unchanged) + ",\"modified\":"
+             + std::to_string(diff.modified) + ",\"added\":" + std::to_string(diff.added) + ",\"removed\":"
+             + std::to_string(diff.removed) + ",\"renumbered\":" + std::to_string(diff.renumbered) + "}}\n";
+        std::cout << out;
+    }
+    else {
+        for (const packdiff::LevelDiff& level : diff.levels) {
+            switch (level.change) {
+                case packdiff::Change::Unchanged:
+                    break;
+                case packdiff::Change::Modified:
+                    std::cout << "modified   Level " << level.afterNumber << ": " << level.changedRows.size() << " rows changed";
+                    if (level.resized) std::cout << ", resized";
+                    if (level.linksChanged) std::cout << ", links changed";
+                    std::cout << '\n';
+                    break;
+                case packdiff::Change::Added:
+                    std::cout << "added      Level " << level.afterNumber << '\n';
+                    break;
+                case packdiff::Change::Removed:
+                    std::cout << "removed    Level " << level.beforeNumber << '\n';
+                    break;
+                case packdiff::Change::Renumbered:
+                    std::cout << "renumbered Level " << level.beforeNumber << " -> " << level.afterNumber << '\n';
+                    break;
+            }
+        }
+        std::cout << diff.unchanged << " unchanged, " << diff.modified << " modified, " << diff.added << " added, "
+                  << diff.removed << " removed, " << diff.renumbered << " renumbered\n";
+    }
+    return diff.isEmpty() ? 0 : 1;
+}
+
+int runMerge(const Options& options) {
+    packdiff::PackText base;
+    packdiff::PackText ours;
+    packdiff::PackText theirs;
+    if (!loadPackText(options.files[0], base) || !loadPackText(options.files[1], ours)
+        || !loadPackText(options.files[2], theirs))
+        return 2;
+    const packdiff::MergeResult merge = packdiff::mergePacks(base.levels, ours.levels, theirs.levels);
+
+    std::string out;
+    for (const packdiff::MergedLevel& level : merge.levels) rle::appendPackRecord(level.number, level.text, out);
+    const std::string error = replaceFile(options.output, out);
+    if (!error.empty()) {
+        std::cerr << options.output << ": " << error << '\n';
+        return 2;
+    }
+
+    if (options.json) {
+        std::string json = "{\"conflicts\":[";
+        for (size_t i = 0; i < merge.conflicts.size(); ++i) {
+            const packdiff::Conflict& conflict = merge.conflicts[i];
+            if (i > 0) json += ',';
+            json += "{\"level\":" + std::to_string(conflict.number);
+            if (conflict.row >= 0) json += ",\"row\":" + std::to_string(conflict.row) + ",\"column\":" + std::to_string(conflict.column);
+            json += ",\"reason\":" + jsonString(conflict.reason) + '}';
+        }
+        json += "],\"summary\":{\"levels\":" + std::to_string(merge.levels.size()) + ",\"autoMerged\":"
+              + std::to_string(merge.autoMerged) + ",\"conflicts\":" + std::to_string(merge.conflicts.size())
+              + ",\"output\":" + jsonString(options.output) + "}}\n";
+        std::cout << json;
+    }
+    else {
+        for (const packdiff::Conflict& conflict : merge.conflicts) {
+            std::cout << "conflict   Level " << conflict.number;
+            if (conflict.row >= 0) std::cout << " (row " << conflict.row + 1 << ", column " << conflict.column + 1 << ')';
+            std::cout << ": " << conflict.reason << '\n';
+        }
+        std::cout << merge.levels.size() << " levels, " << merge.autoMerged << " merged from both sides, "
+                  << merge.conflicts.size() << " conflicts -> " << options.output << '\n';
+    }
+    return merge.conflicts.empty() ? 0 : 1;
+}
+
+int usage(const char* message) {
+    if (message) std::cerr << "level-cli: " << message << '\n';
+    std::cerr << "usage: level-cli validate|stats|reencode|convert [--to rll|rlb [--shared-rows]] [--json] [--jobs N]\n"
+                 "                 [--output DIR | --in-place] <pack>...\n"
+                 "       level-cli diff [--json] <before> <after>\n"
+                 "       level-cli merge [--json] --output FILE <base> <ours> <theirs>\n";
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) return usage(nullptr);
+    Options options;
+    const std::string command = argv[1];
+    if (command == "validate") options.command = Command::Validate;
+    else if (command == "stats") options.command = Command::Stats;
+    else if (command == "reencode") options.command = Command::Reencode;
+    else if (command == "convert") options.command = Command::Convert;
+    else if (command == "diff") options.command = Command::Diff;
+    else if (command == "merge") options.command = Command::Merge;
+    else return usage("unknown command");
+
+    for (int i = 2; i < argc; ++i) {
+        const std::string argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (argument == "--json") options.json = true;
+        else if (argument == "--in-place") options.inPlace = true;
+        else if (argument == "--shared-rows") options.sharedRows = true;
+        else if (argument == "--jobs" && hasValue) options.jobs = static_cast<unsigned>(std::max(0, std::atoi(argv[++i])));
+        else if (argument == "--output" && hasValue) options.output = argv[++i];
+        else if (argument == "--to" && hasValue) options.format = argv[++i];
+        else if (argument.rfind("--", 0) == 0) return usage(("unknown option " + argument).c_str());
+        else options.files.push_back(argument);
+    }
+    if (options.files.empty()) return usage("no input files");
+    if (options.command == Command::Diff) {
+        if (options.files.size() != 2) return usage("diff needs two packs");
+        return runDiff(options);
+    }
+    if (options.command == Command::Merge) {
+        if (options.files.size() != 3) return usage("merge needs a base and two packs");
+        if (options.output.empty()) return usage("merge needs --output FILE");
+        return runMerge(options);
+    }
+    if (options.command == Command::Convert && options.format != "rll" && options.format != "rlb")
+        return usage("convert needs --to rll or --to rlb");
+    if (options.sharedRows && (options.command != Command::Convert || options.format != "rlb"))
+        return usage("--shared-rows needs convert --to rlb");
+    if (writesOutput(options) && options.inPlace == !options.output.empty())
+        return usage("give exactly one of --output DIR and --in-place");
+    if (!options.output.empty()) {
+        std::error_code error;
+        fs::create_directories(options.output, error);
+        if (error) return usage(("unable to create " + options.output).c_str());
+    }
+
+    std::vector<std::unique_ptr<FileJob>> jobs;
+    jobs.reserve(options.files.size());
+    {
+        WorkStealingPool pool(options.jobs);
+        for (const std::string& path : options.files) {
+            jobs.push_back(std::make_unique<FileJob>());
+            FileJob& job = *jobs.back();
+            job.path = path;
+            pool.submit([&options, &pool, &job] { processFile(options, pool, job); });
+        }
+        pool.wait();
+    }
+
+    if (options.json) printJson(options, jobs);
+    else printText(options, jobs);
+    const bool failed = std::any_of(jobs.begin(), jobs.end(), [](const auto& job) { return job->failed(); });
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,87 @@
+#ifndef LEVELGENERATOR_H
+#define LEVELGENERATOR_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "RleCodec.h"
+
+// Seeded synthetic levels for benchmarks. The same seed always produces the same
+// tiles, so timings from different builds measure the same work.
+namespace levelgen {
+
+enum class Pattern {
+    Noise,       // every tile drawn independently: runs are short and tiles mixed
+    Alternating, // checkerboard of two tiles: every run has length one, the encoder's worst case
+    Corridors    // long air runs between wall bands with sparse pickups: typical, highly compressible
+};
+
+inline const char* patternName(Pattern pattern) {
+    switch (pattern) {
+        case Pattern::Noise:       return "noise";
+        case Pattern::Alternating: return "alternating";
+        case Pattern::Corridors:   return "corridors";
+    }
+    return "unknown";
+}
+
+constexpr char tileSet[] = "-#=*^&LRUDPSE";
+
+inline rle::Level generate(Pattern pattern, int rows, int columns, uint32_t seed) {
+    std::mt19937 random(seed);
+    rle::Level level;
+    level.rows = rows;
+    level.columns = columns;
+    level.tiles.resize(static_cast<size_t>(rows) * columns);
+    for (int& next : level.nextLevel) next = static_cast<int>(random() % 16);
+
+    char* tiles = level.tiles.data();
+    switch (pattern) {
+        case Pattern::Noise: {
+            std::uniform_int_distribution<int> tile(0, static_cast<int>(sizeof(tileSet)) - 2);
+            for (size_t i = 0; i < level.tiles.size(); ++i) tiles[i] = tileSet[tile(random)];
+            break;
+        }
+        case Pattern::Alternating:
+            for (int r = 0; r < rows; ++r) {
+                for (int c = 0; c < columns; ++c) tiles[static_cast<size_t>(r) * columns + c] = (r + c) % 2 ? '#' : '-';
+            }
+            break;
+        case Pattern::Corridors: {
+            std::uniform_int_distribution<int> percent(0, 99);
+            for (int r = 0; r < rows; ++r) {
+                char* row = tiles + static_cast<size_t>(r) * columns;
+                const bool wall = r == 0 || r + 1 == rows || r % 8 == 7;
+                for (int c = 0; c < columns; ++c) row[c] = wall ? '#' : '-';
+                if (wall) {
+                    // Gaps to drop through from one corridor to the next.
+                    for (int c = 0; c < columns; c += 32 + percent(random)) row[c] = '-';
+                }
+                else if (r % 8 == 6) {
+                    for (int c = 0; c < columns; c += 16 + percent(random)) row[c] = "*^&PSE"[percent(random) % 6];
+                }
+            }
+            break;
+        }
+    }
+    return level;
+}
+
+// A pack of count small levels, mostly corridors with some noise and alternating
+// levels mixed in, in the proportions 7:2:1.
+inline std::vector<rle::Level> generatePack(size_t count, int rows, int columns, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::vector<rle::Level> levels;
+    levels.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t pick = random() % 10;
+        const Pattern pattern = pick < 7 ? Pattern::Corridors : pick < 9 ? Pattern::Noise : Pattern::Alternating;
+        levels.push_back(generate(pattern, rows, columns, static_cast<uint32_t>(random())));
+    }
+    return levels;
+}
+
+} // namespace levelgen
+
+#endif // LEVELGENERATOR_H
@@ -0,0 +1,55 @@
+#ifndef LEVELLISTMODEL_H
+#define LEVELLISTMODEL_H
+
+#include <QAbstractListModel>
+#include "LevelPack.h"
+
+class LevelListModel : public QAbstractListModel
+{
+public:
+    explicit LevelListModel(QObject *parent = nullptr)
+    : QAbstractListModel(parent) {}
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override {
+        return parent.isValid() ? 0 : levels.count();
+    }
+
+    QVariant data(const QModelIndex& index, int role) const override {
+        if (!index.isValid() || index.row() >= levels.count()) return {};
+        if (role == Qt::DisplayRole) return levels.name(index.row());
+        return {};
+    }
+
+    LevelPack& pack() { return levels; }
+    const LevelPack& pack() const { return levels; }
+
+    bool load(const QString& path) {
+        beginResetModel();
+        const bool opened = levels.open(path);
+        endResetModel();
+        return opened;
+    }
+
+    void setLevel(int row, QByteArray encoded) {
+        levels.replace(row, std::move(encoded));
+    }
+
+    int appendLevel(int number, QByteArray encoded) {
+        beginInsertRows(QModelIndex(), levels.count(), levels.count());
+        const int row = levels.append(number, std::move(encoded));
+        endInsertRows();
+        return row;
+    }
+
+    void removeLevel(int row) {
+        beginRemoveRows(QModelIndex(), row, row);
+        levels.remove(row);
+        endRemoveRows();
+        if (levels.count() > 0) emit dataChanged(index(0), index(levels.count() - 1), {Qt::DisplayRole});
+    }
+
+private:
+    LevelPack levels;
+};
+
+#endif // LEVELLISTMODEL_H
@@ -0,0 +1,78 @@
+#include "LevelMinimap.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <cmath>
+
+LevelMinimap::LevelMinimap(LevelCanvas* canvas, QWidget *parent)
+    : QWidget(parent), canvas(canvas)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMinimumSize(120, 120);
+    canvas->addTilesChangedHandler([this](const QRect& cells) { tilesChanged(cells); });
+    canvas->setViewChangedHandler([this] { viewChanged(); });
+}
+
+QTransform LevelMinimap::levelTransform() const {
+    const TileMap& tiles = canvas->tiles();
+    if (tiles.isEmpty()) return {};
+    const qreal scale = std::min(qreal(width()) / tiles.columns(), qreal(height()) / tiles.rows());
+    return QTransform(scale, 0, 0, scale, (width() - tiles.columns() * scale) / 2, (height() - tiles.rows() * scale) / 2);
+}
+
+void LevelMinimap::tilesChanged(const QRect& cells) {
+    update(levelTransform().mapRect(QRectF(cells)).toAlignedRect().adjusted(-1, -1, 1, 1));
+    viewChanged();
+}
+
+void LevelMinimap::viewChanged() {
+    const QRect frame = levelTransform().mapRect(canvas->visibleCells()).toAlignedRect();
+    if (frame == viewFrame) return;
+    update(viewFrame.adjusted(-1, -1, 1, 1));
+    update(frame.adjusted(-1, -1, 1, 1));
+    viewFrame = frame;
+}
+
+void LevelMinimap::paintEvent(QPaintEvent *event) {
+    QPainter painter(this);
+    painter.fillRect(event->rect(), palette().window());
+    const TileMap& tiles = canvas->tiles();
+    if (tiles.isEmpty()) return;
+
+    const TileMipmap& colors = canvas->colorMipmap();
+    const QTransform transform = levelTransform();
+    const int index = colors.levelFor(transform.m11());
+    const int block = 1 << index;
+    const QRectF exposed = transform.inverted().mapRect(QRectF(event->rect()))
+                               .intersected(QRectF(0, 0, tiles.columns(), tiles.rows()));
+    if (!exposed.isEmpty()) {
+        const QRect source(QPoint(int(exposed.left()) / block, int(exposed.top()) / block),
+                           QPoint(int(std::ceil(exposed.right()) - 1) / block, int(std::ceil(exposed.bottom()) - 1) / block));
+        const QRectF target(source.x() * block, source.y() * block, source.width() * block, source.height() * block);
+        painter.save();
+        painter.setTransform(transform);
+        painter.setClipRect(QRectF(0, 0, tiles.columns(), tiles.rows()));
+        painter.drawImage(target, colors.level(index), source);
+        painter.restore();
+    }
+
+    viewFrame = transform.mapRect(canvas->visibleCells()).toAlignedRect();
+    painter.setPen(QPen(Qt::red, 1));
+    painter.drawRect(viewFrame.adjusted(0, 0, -1, -1));
+}
+
+void LevelMinimap::mousePressEvent(QMouseEvent *event) {
+    if (event->button() != Qt::LeftButton) return;
+    // Grabbing the frame drags it from where it was grabbed; clicking elsewhere centers the view there.
+    dragOffset = viewFrame.contains(event->pos()) ? event->pos() - viewFrame.center() : QPoint();
+    moveCanvasTo(event->pos() - dragOffset);
+}
+
+void LevelMinimap::mouseMoveEvent(QMouseEvent *event) {
+    if (event->buttons() & Qt::LeftButton) moveCanvasTo(event->pos() - dragOffset);
+}
+
+void LevelMinimap::moveCanvasTo(const QPoint& position) {
+    if (canvas->tiles().isEmpty()) return;
+    canvas->centerOn(levelTransform().inverted().map(QPointF(position)));
+}
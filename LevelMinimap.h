@@ -0,0 +1,34 @@
+#ifndef LEVELMINIMAP_H
+#define LEVELMINIMAP_H
+
+#include <QWidget>
+#include "LevelCanvas.h"
+
+// Overview of the whole level drawn from the canvas color pyramid, with a frame
+// around the part the canvas shows. Clicking or dragging moves the canvas there.
+// Tile edits repaint only the minimap pixels covering the changed cells.
+class LevelMinimap : public QWidget
+{
+public:
+    explicit LevelMinimap(LevelCanvas* canvas, QWidget *parent = nullptr);
+
+    QSize sizeHint() const override { return {240, 240}; }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private:
+    // Maps cell coordinates to widget pixels, fitting the level into the widget.
+    QTransform levelTransform() const;
+    void tilesChanged(const QRect& cells);
+    void viewChanged();
+    void moveCanvasTo(const QPoint& position);
+
+    LevelCanvas* canvas;
+    QRect viewFrame;
+    QPoint dragOffset;
+};
+
+#endif // LEVELMINIMAP_H
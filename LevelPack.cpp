@@ -0,0 +1,467 @@
+#include "LevelPack.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+#include "RlbFormat.h"
+#include "Trace.h"
+
+namespace {
+
+constexpr qint64 minCompactionBytes = 1 << 20;
+
+// Journal records are only valid on top of the exact base file they were written against.
+QByteArray baseRecord(const QString& path) {
+    const QFileInfo info(path);
+    const qint64 modified = info.exists() ? info.lastModified().toMSecsSinceEpoch() : 0;
+    return "@base " + QByteArray::number(info.exists() ? info.size() : 0) + ' ' + QByteArray::number(modified) + '\n';
+}
+
+QByteArray putRecord(int index, int number, const QByteArray& data) {
+    return "@put " + QByteArray::number(index) + ' ' + QByteArray::number(number) + ' '
+         + QByteArray::number(data.size()) + ' ' + QByteArray::number(qChecksum(data)) + '\n' + data + '\n';
+}
+
+QByteArray removeRecord(int index) {
+    return "@remove " + QByteArray::number(index) + '\n';
+}
+
+} // namespace
+
+bool LevelPack::isBinaryPath(const QString& path) {
+    return path.endsWith(".rlb", Qt::CaseInsensitive);
+}
+
+bool LevelPack::Storage::map(const QString& path, QString& error) {
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+    size = file.size();
+    if (size > 0) {
+        mapped = reinterpret_cast<const char*>(file.map(0, size));
+        if (!mapped) {
+            error = file.errorString();
+            file.close();
+            size = 0;
+            return false;
+        }
+    }
+    binary = rlb::isRlb(std::string_view(mapped, mapped ? size : 0));
+    rlb::PackReader reader;
+    if (binary && !reader.open(std::string_view(mapped, size)) && reader.rows()) {
+        rows = *reader.rows();
+        sharedRows = true;
+    }
+    return true;
+}
+
+void LevelPack::Storage::waitForReaders() {
+    while (readers > 0) released.wait(&lock);
+}
+
+void LevelPack::Storage::unmap() {
+    if (mapped) file.unmap(reinterpret_cast<uchar*>(const_cast<char*>(mapped)));
+    mapped = nullptr;
+    size = 0;
+    binary = false;
+    sharedRows = false;
+    rows = rlb::RowDictionary();
+    file.close();
+}
+
+LevelPack::LevelPack()
+    : storage(std::make_shared<Storage>())
+{
+    writer.setMaxThreadCount(1);
+}
+
+LevelPack::~LevelPack() {
+    close();
+}
+
+bool LevelPack::open(const QString& path) {
+    TRACE_SCOPE("LevelPack::open");
+    close();
+    filePath = path;
+    bool opened = storage->map(path, lastError);
+    if (opened && !scan()) {
+        QMutexLocker locker(&storage->lock);
+        storage->unmap();
+        entries.clear();
+        opened = false;
+    }
+    // A pack that is there but cannot be read must not be compacted: that would
+    // replace it with whatever levels the journal holds. A missing one is a new pack.
+    unreadable = !opened && QFileInfo::exists(path);
+    if (!unreadable) replayJournal();
+    return opened;
+}
+
+void LevelPack::close() {
+    compact();
+    writer.waitForDone();
+    QMutexLocker locker(&storage->lock);
+    storage->waitForReaders();
+    storage->unmap();
+    storage->rebased.clear();
+    storage->rebasePending = false;
+    entries.clear();
+    pendingJournal.clear();
+    journalBytes = 0;
+    unreadable = false;
+}
+
+void LevelPack::compact() {
+    if (journalBytes > 0) scheduleCompaction();
+}
+
+void LevelPack::waitForWrites() {
+    writer.waitForDone();
+}
+
+void LevelPack::setErrorHandler(QObject* context, std::function<void(const QString&)> handler) {
+    errorContext = context;
+    errorHandler = std::move(handler);
+}
+
+bool LevelPack::scan() {
+    if (storage->binary) {
+        rlb::PackReader reader;
+        if (rle::Error error = reader.open(std::string_view(storage->mapped, storage->size))) {
+            lastError = QString::fromStdString(rle::describe(error));
+            return false;
+        }
+        entries.reserve(static_cast<qsizetype>(reader.count()));
+        for (uint32_t i = 0; i < reader.count(); ++i) {
+            const rlb::TableEntry table = reader.entry(i);
+            Entry entry;
+            entry.offset = static_cast<qint64>(table.offset);
+            entry.length = table.length;
+            entry.number = table.number;
+            entry.id = nextId++;
+            entries.push_back(entry);
+        }
+        return true;
+    }
+
+    for (const rle::PackRecord& record : rle::scanPack(std::string_view(storage->mapped, storage->size))) {
+        Entry entry;
+        entry.offset = static_cast<qint64>(record.offset);
+        entry.length = static_cast<qint64>(record.length);
+        entry.number = record.number;
+        entry.id = nextId++;
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+void LevelPack::replayJournal() {
+    QFile journal(journalPath());
+    if (!journal.open(QIODevice::ReadOnly)) return;
+    const QByteArray content = journal.readAll();
+    journal.close();
+
+    const QByteArray base = baseRecord(filePath);
+    if (!content.startsWith(base)) {
+        QFile::remove(journalPath());
+        return;
+    }
+
+    qsizetype position = base.size();
+    while (position < content.size()) {
+        const qsizetype eol = content.indexOf('\n', position);
+        if (eol < 0) break;
+        const QList<QByteArray> fields = content.mid(position, eol - position).split(' ');
+        bool valid[4] = {false, false, false, false};
+        if (fields.size() == 5 && fields[0] == "@put") {
+            const int index = fields[1].toInt(&valid[0]);
+            const int number = fields[2].toInt(&valid[1]);
+            const qsizetype length = fields[3].toLongLong(&valid[2]);
+            const quint16 checksum = fields[4].toUShort(&valid[3]);
+            if (!valid[0] || !valid[1] || !valid[2] || !valid[3] || index < 0 || index > count() || length < 0) break;
+            const qsizetype next = eol + 1 + length + 1;
+            if (next > content.size() || content[next - 1] != '\n') break;
+            QByteArray data = content.mid(eol + 1, length);
+            if (qChecksum(data) != checksum) break;
+            if (index == count()) {
+                Entry entry;
+                entry.id = nextId++;
+                entries.push_back(entry);
+            }
+            Entry& entry = entries[index];
+            entry.number = number;
+            entry.data = std::move(data);
+            entry.edited = true;
+            entry.revision++;
+            position = next;
+        }
+        else if (fields.size() == 2 && fields[0] == "@remove") {
+            const int index = fields[1].toInt(&valid[0]);
+            if (!valid[0] || index < 0 || index >= count()) break;
+            entries.remove(index);
+            for (int i = 0; i < count(); ++i) entries[i].number = i + 1;
+            position = eol + 1;
+        }
+        else break;
+    }
+
+    // A torn record at the tail means the editor stopped mid-write; keep the intact prefix.
+    if (position < content.size()) QFile::resize(journalPath(), position);
+    journalBytes = position;
+    if (journalBytes > std::max(minCompactionBytes, storage->size / 4)) scheduleCompaction();
+}
+
+void LevelPack::save() {
+    if (pendingJournal.isEmpty()) return;
+    const QByteArray records = std::move(pendingJournal);
+    pendingJournal.clear();
+    journalBytes += records.size();
+
+    writer.start([path = filePath, journal = journalPath(), records, report = errorReporter()] {
+        QFile output(journal);
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            report("Unable to write " + journal + ": " + output.errorString());
+            return;
+        }
+        if (output.size() == 0) output.write(baseRecord(path));
+        if (output.write(records) != records.size() || !output.flush())
+            report("Unable to write " + journal + ": " + output.errorString());
+    });
+
+    qint64 baseSize;
+    {
+        QMutexLocker locker(&storage->lock);
+        baseSize = storage->size;
+    }
+    if (journalBytes > std::max(minCompactionBytes, baseSize / 4)) scheduleCompaction();
+}
+
+void LevelPack::scheduleCompaction() {
+    if (unreadable) return;
+    journalBytes = 0;
+    writer.start([storage = storage, snapshot = entries, path = filePath, journal = journalPath(), report = errorReporter()]() mutable {
+        TRACE_SCOPE("LevelPack::compact");
+        {
+            // The entries may predate an earlier compaction that has moved their records since.
+            QMutexLocker locker(&storage->lock);
+            rebase(snapshot, storage->rebased);
+        }
+        // Only this thread remaps the file, so the old mapping stays valid while it is copied.
+        QSaveFile output(path);
+        if (!output.open(QIODevice::WriteOnly)) {
+            report("Unable to compact " + path + ": " + output.errorString());
+            return;
+        }
+        QHash<quint64, Span> spans;
+        QString error;
+        if (!writePack(*storage, snapshot, output, storage->binary, &spans, error)) {
+            output.cancelWriting();
+            report("Unable to compact " + path + ": " + error);
+            return;
+        }
+
+        QMutexLocker locker(&storage->lock);
+        storage->waitForReaders();
+        storage->unmap();
+        const bool committed = output.commit();
+        if (!storage->map(path, error)) report("Unable to reopen " + path + ": " + error);
+        if (!committed) {
+            report("Unable to compact " + path + ": " + output.errorString());
+            return;
+        }
+        // Merged, so entries copied before this compaction was queued can still be rebased.
+        storage->rebased.insert(spans);
+        storage->rebasePending = true;
+        QFile::remove(journal);
+    });
+}
+
+void LevelPack::applyRebase() const {
+    if (!storage->rebasePending) return;
+    rebase(entries, storage->rebased);
+    storage->rebasePending = false;
+}
+
+void LevelPack::rebase(QVector<Entry>& entries, const QHash<quint64, Span>& spans) {
+    for (Entry& entry : entries) {
+        const auto it = spans.constFind(entry.id);
+        if (it == spans.constEnd()) continue;
+        entry.offset = it->offset;
+        entry.length = it->length;
+        if (entry.edited && entry.revision == it->revision) {
+            entry.edited = false;
+            entry.data = QByteArray();
+        }
+    }
+}
+
+std::function<void(const QString&)> LevelPack::errorReporter() const {
+    return [context = errorContext, handler = errorHandler](const QString& message) {
+        if (!context || !handler) {
+            qWarning() << message;
+            return;
+        }
+        QMetaObject::invokeMethod(context.data(), [handler, message] { handler(message); }, Qt::QueuedConnection);
+    };
+}
+
+int LevelPack::maxNumber() const {
+    int maxNumber = 0;
+    for (const Entry& entry : entries) maxNumber = std::max(maxNumber, entry.number);
+    return maxNumber;
+}
+
+bool LevelPack::writePack(const Storage& storage, const QVector<Entry>& snapshot, QFileDevice& output, bool binary,
+                          QHash<quint64, Span>* spans, QString& error) {
+    if (spans) spans->reserve(snapshot.size());
+    std::string scratch;
+    if (!binary) {
+        qint64 position = 0;
+        for (const Entry& entry : snapshot) {
+            const QByteArray header = "; Level " + QByteArray::number(entry.number) + '\n';
+            std::string_view text;
+            if (rle::Error failure = textOf(storage, entry, scratch, text)) {
+                error = QString("Level %1: %2").arg(entry.number).arg(QString::fromStdString(rle::describe(failure)));
+                return false;
+            }
+            output.write(header);
+            position += header.size();
+            if (spans) spans->insert(entry.id, {position, static_cast<qint64>(text.size()), entry.revision});
+            output.write(text.data(), static_cast<qint64>(text.size()));
+            output.write("\n\n");
+            position += static_cast<qint64>(text.size()) + 2;
+        }
+        return true;
+    }
+
+    // Untouched levels of a .rlb pack keep their encoded rows; only edited ones are decoded.
+    rlb::PackWriter packWriter(storage.sharedRows);
+    std::string block(rlb::headerSize, '\0');
+    rle::Level level;
+    for (const Entry& entry : snapshot) {
+        rlb::TableEntry written;
+        rle::Error failure;
+        if (!entry.edited && storage.binary)
+            failure = packWriter.addRecord(entry.number, recordOf(storage, entry), storage.dictionary(), block, written);
+        else if (!(failure = decodeEntry(storage, entry, level))) written = packWriter.add(entry.number, level, block);
+        if (failure) {
+            error = QString("Level %1: %2").arg(entry.number).arg(QString::fromStdString(rle::describe(failure)));
+            return false;
+        }
+        if (spans) spans->insert(entry.id, {static_cast<qint64>(written.offset), written.length, entry.revision});
+        output.write(block.data(), static_cast<qint64>(block.size()));
+        block.clear();
+    }
+    char header[rlb::headerSize];
+    packWriter.finish(block, header);
+    output.write(block.data(), static_cast<qint64>(block.size()));
+    if (!output.seek(0) || output.write(header, sizeof(header)) != sizeof(header)) {
+        error = output.errorString();
+        return false;
+    }
+    return true;
+}
+
+std::string_view LevelPack::recordOf(const Storage& storage, const Entry& entry) {
+    if (!storage.mapped || entry.offset + entry.length > storage.size) return {};
+    return {storage.mapped + entry.offset, static_cast<size_t>(entry.length)};
+}
+
+rle::Error LevelPack::textOf(const Storage& storage, const Entry& entry, std::string& scratch, std::string_view& text) {
+    if (entry.edited) {
+        text = {entry.data.constData(), static_cast<size_t>(entry.data.size())};
+        return {};
+    }
+    if (storage.binary) {
+        rle::Level level;
+        text = {};
+        if (rle::Error error = rlb::decodeLevel(recordOf(storage, entry), level, storage.dictionary())) return error;
+        rle::encode(level, scratch);
+        text = scratch;
+        return {};
+    }
+
+    text = rle::recordText(recordOf(storage, entry), scratch);
+    return {};
+}
+
+rle::Error LevelPack::decodeEntry(const Storage& storage, const Entry& entry, rle::Level& level) {
+    if (!entry.edited && storage.binary) return rlb::decodeLevel(recordOf(storage, entry), level, storage.dictionary());
+    std::string scratch;
+    std::string_view text;
+    if (rle::Error error = textOf(storage, entry, scratch, text)) return error;
+    return rle::decode(text, level);
+}
+
+QByteArray LevelPack::encoded(int index) const {
+    QMutexLocker locker(&storage->lock);
+    applyRebase();
+    std::string scratch;
+    std::string_view text;
+    textOf(*storage, entries[index], scratch, text);
+    return {text.data(), static_cast<qsizetype>(text.size())};
+}
+
+rle::Error LevelPack::read(int index, rle::Level& level) const {
+    TRACE_SCOPE("LevelPack::read");
+    QMutexLocker locker(&storage->lock);
+    applyRebase();
+    return decodeEntry(*storage, entries[index], level);
+}
+
+std::shared_ptr<const LevelPack::Snapshot> LevelPack::snapshot() const {
+    QMutexLocker locker(&storage->lock);
+    applyRebase();
+    ++storage->readers;
+    return std::shared_ptr<const Snapshot>(new Snapshot(storage, entries));
+}
+
+LevelPack::Snapshot::Snapshot(std::shared_ptr<Storage> storage, QVector<Entry> entries)
+    : storage(std::move(storage)), entries(std::move(entries))
+{
+}
+
+LevelPack::Snapshot::~Snapshot() {
+    QMutexLocker locker(&storage->lock);
+    if (--storage->readers == 0) storage->released.wakeAll();
+}
+
+std::string_view LevelPack::Snapshot::encoded(int index, std::string& scratch) const {
+    std::string_view text;
+    textOf(*storage, entries[index], scratch, text);
+    return text;
+}
+
+rle::Error LevelPack::Snapshot::read(int index, rle::Level& level) const {
+    return decodeEntry(*storage, entries[index], level);
+}
+
+void LevelPack::replace(int index, QByteArray encoded) {
+    Entry& entry = entries[index];
+    pendingJournal += putRecord(index, entry.number, encoded);
+    entry.data = std::move(encoded);
+    entry.edited = true;
+    entry.revision++;
+}
+
+int LevelPack::append(int number, QByteArray encoded) {
+    Entry entry;
+    entry.number = number;
+    entry.id = nextId++;
+    entry.revision = 1;
+    pendingJournal += putRecord(count(), number, encoded);
+    entry.data = std::move(encoded);
+    entry.edited = true;
+    entries.push_back(std::move(entry));
+    return count() - 1;
+}
+
+void LevelPack::remove(int index) {
+    pendingJournal += removeRecord(index);
+    entries.remove(index);
+    for (int i = 0; i < count(); ++i) entries[i].number = i + 1;
+}
@@ -0,0 +1,160 @@
+#ifndef LEVELPACK_H
+#define LEVELPACK_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QPointer>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "RleCodec.h"
+#include "RlbFormat.h"
+
+// A level pack indexed by record offsets: the "; Level N" headers of a text .rll
+// pack, or the level table of a binary .rlb pack (see RlbFormat.h), detected by
+// its magic. The file stays memory-mapped and a level is only decoded when it is read;
+// in a .rlb pack with shared rows, the levels read the one mapped copy of each row.
+//
+// Saving appends only the changed records to "<pack>.journal" on a background
+// thread; the journal is replayed on open and folded back into the pack by a
+// background compaction (when it grows, on export and on close) that replaces
+// the file atomically through QSaveFile. Import and export stream the file on disk
+// instead, see PackTransfer. Background jobs read levels through a Snapshot.
+class LevelPack
+{
+public:
+    class Snapshot;
+
+    LevelPack();
+    ~LevelPack();
+    LevelPack(const LevelPack&) = delete;
+    LevelPack& operator=(const LevelPack&) = delete;
+
+    bool open(const QString& path);
+    void close();
+    void save();
+    void compact();
+    void waitForWrites();
+    static bool isBinaryPath(const QString& path);
+    void setErrorHandler(QObject* context, std::function<void(const QString&)> handler);
+
+    QString path() const { return filePath; }
+    QString journalPath() const { return filePath + ".journal"; }
+    QString errorString() const { return lastError; }
+
+    int count() const { return static_cast<int>(entries.size()); }
+    int number(int index) const { return entries[index].number; }
+    QString name(int index) const { return QString("Level %1").arg(entries[index].number); }
+    int maxNumber() const;
+
+    QByteArray encoded(int index) const;
+    rle::Error read(int index, rle::Level& level) const;
+    // Costs no copy of the levels, so it is cheap to take on every edit.
+    std::shared_ptr<const Snapshot> snapshot() const;
+
+    void replace(int index, QByteArray encoded);
+    int append(int number, QByteArray encoded);
+    void remove(int index);
+
+private:
+    struct Entry {
+        qint64 offset = 0;
+        qint64 length = 0;
+        int number = 0;
+        QByteArray data;
+        bool edited = false;
+        quint64 id = 0;
+        quint64 revision = 0;
+    };
+
+    struct Span {
+        qint64 offset;
+        qint64 length;
+        quint64 revision;
+    };
+
+    // Everything the writer thread touches, guarded by lock.
+    struct Storage {
+        QMutex lock;
+        QFile file;
+        const char* mapped = nullptr;
+        qint64 size = 0;
+        bool binary = false;
+        // Kept by compaction, so a pack with shared rows stays one.
+        bool sharedRows = false;
+        rlb::RowDictionary rows;
+        // Where the compactions since open put each entry, the latest one winning; kept
+        // until close, as a queued compaction may hold entries from before any of them.
+        QHash<quint64, Span> rebased;
+        bool rebasePending = false;
+        // Live snapshots; the mapping is only replaced or closed when there are none.
+        int readers = 0;
+        QWaitCondition released;
+
+        bool map(const QString& path, QString& error);
+        void unmap();
+        // With lock held.
+        void waitForReaders();
+        const rlb::RowDictionary* dictionary() const { return sharedRows ? &rows : nullptr; }
+    };
+
+    static std::string_view recordOf(const Storage& storage, const Entry& entry);
+    // The encoded level, from the edit, the text record or a re-encoded .rlb record.
+    static rle::Error textOf(const Storage& storage, const Entry& entry, std::string& scratch, std::string_view& text);
+    static rle::Error decodeEntry(const Storage& storage, const Entry& entry, rle::Level& level);
+    static bool writePack(const Storage& storage, const QVector<Entry>& snapshot, QFileDevice& output, bool binary,
+                          QHash<quint64, Span>* spans, QString& error);
+    bool scan();
+    void replayJournal();
+    void applyRebase() const;
+    static void rebase(QVector<Entry>& entries, const QHash<quint64, Span>& spans);
+    void scheduleCompaction();
+    std::function<void(const QString&)> errorReporter() const;
+
+    QString filePath;
+    QString lastError;
+    std::shared_ptr<Storage> storage;
+    mutable QVector<Entry> entries;
+    quint64 nextId = 1;
+    QByteArray pendingJournal;
+    qint64 journalBytes = 0;
+    // The file exists but open() could not read it; see open().
+    bool unreadable = false;
+    QThreadPool writer;
+    QPointer<QObject> errorContext;
+    std::function<void(const QString&)> errorHandler;
+};
+
+// The levels of a pack as they were when the snapshot was taken, readable from any
+// thread without locking while the pack goes on being edited. It shares the entry
+// table and the mapped file with the pack; a compaction or close waits for it to be
+// released, so background jobs should hold one only while they read.
+class LevelPack::Snapshot
+{
+public:
+    ~Snapshot();
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    int count() const { return static_cast<int>(entries.size()); }
+    int number(int index) const { return entries[index].number; }
+    // The encoded level; the view points into the pack or into scratch.
+    std::string_view encoded(int index, std::string& scratch) const;
+    rle::Error read(int index, rle::Level& level) const;
+
+private:
+    friend class LevelPack;
+    Snapshot(std::shared_ptr<Storage> storage, QVector<Entry> entries);
+
+    std::shared_ptr<Storage> storage;
+    QVector<Entry> entries;
+};
+
+#endif // LEVELPACK_H
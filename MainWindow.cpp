@@ -1,5 +1,15 @@
 #include "MainWindow.h"
 #include "utilities.h"
+#include "TileRaster.h"
+#include "TileClipboard.h"
+#include "PackDiff.h"
+#include <filesystem>
+
+namespace {
+
+const QRgb changedCellColor = qPremultiply(qRgba(230, 0, 230, 110));
+
+} // namespace
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), selectedTile(TileType::Wall)
@@ -11,24 +21,60 @@ MainWindow::MainWindow(QWidget *parent)
 
     auto *mainLayout = new QVBoxLayout(centralWidget);
 
-    level = new QTableWidget(20, 20);
-    level->verticalHeader()->setDefaultSectionSize(32);
-    level->horizontalHeader()->setDefaultSectionSize(32);
-    level->verticalHeader()->setMinimumSectionSize(32);
-    level->horizontalHeader()->setMinimumSectionSize(32);
-    level->verticalHeader()->setMaximumSectionSize(300);
-    level->horizontalHeader()->setMaximumSectionSize(300);
-    level->setEditTriggers(QAbstractItemView::NoEditTriggers);
-    level->setSelectionMode(QAbstractItemView::NoSelection);
-    level->setSelectionBehavior(QAbstractItemView::SelectItems);
-    level->setDragDropMode(QAbstractItemView::NoDragDrop);
+    level = new LevelCanvas(&tileIconManager);
     level->setFocusPolicy(Qt::StrongFocus);
     level->viewport()->installEventFilter(this);
-    connect(level, &QTableWidget::cellClicked, this, &MainWindow::onTileClicked);
     mainLayout->addWidget(level);
 
+    worldPanel = new WorldPanel();
+    worldPanel->setLevelActivatedHandler([this](int number) { showWorldLevel(number); });
+    worldAnalyzer.setResultHandler(this, [this](const std::vector<world::LevelNode>& nodes, const world::Report& report) {
+        worldPanel->showReport(nodes, report);
+    });
+    searchPanel = new SearchPanel();
+    searchPanel->setSearchHandler([this](const PatternMatcher& matcher) { patternSearch.start(levelModel->pack(), matcher); });
+    searchPanel->setStopHandler([this] { patternSearch.cancel(); });
+    searchPanel->setSelectionSource([this] { return selectionText(); });
+    searchPanel->setMatchActivatedHandler([this](int number, const QRect& cells) { showSearchMatch(number, cells); });
+    packTransfer.setHandlers(this,
+        [this](int percent) {
+            if (transferProgress) transferProgress->setValue(percent);
+        },
+        [this](const PackTransfer::Result& result) { transferFinished(result); });
+    patternSearch.setHandlers(this,
+        [this](const std::vector<PatternSearch::LevelMatches>& results) { searchPanel->addResults(results); },
+        [this](const PatternSearch::Summary& summary) { searchPanel->searchFinished(summary); });
+    diffPanel = new DiffPanel();
+    diffPanel->setCompareHandler([this](const QString& path) { packComparer.start(levelModel->pack(), path); });
+    diffPanel->setChangeActivatedHandler([this](int index) { showChange(index); });
+    packComparer.setResultHandler(this, [this](std::shared_ptr<const PackComparer::Comparison> result) {
+        hideDiffOverlay();
+        comparison = std::move(result);
+        diffPanel->showComparison(*comparison);
+    });
+    reachAnalyzer.setResultHandler(this, [this](const QImage& overlay, const Reachability::Summary& summary) {
+        if (!diffVisible) level->setOverlay(overlay);
+        showReachSummary(summary);
+    });
+    autoSaver.setSnapshotSource([this] {
+        AutoSaver::Snapshot snapshot;
+        snapshot.number = editedIndex >= 0 ? levelModel->pack().number(editedIndex) : 0;
+        snapshot.tiles = level->tiles();
+        dirWidget->getValues(snapshot.nextLevel);
+        // Runs once saveNow() has recorded how long this took.
+        QMetaObject::invokeMethod(this, [this] { updateAutosaveStatus(); }, Qt::QueuedConnection);
+        return snapshot;
+    });
+    level->addTilesChangedHandler([this](const QRect& cells) {
+        autoSaver.markDirty();
+        if (diffVisible) updateDiffOverlay(cells);
+        if (!reachVisible) return;
+        if (cells == QRect(0, 0, level->columnCount(), level->rowCount())) reachAnalyzer.setTiles(level->tiles());
+        else reachAnalyzer.tilesChanged(level->tiles(), cells);
+    });
+
     buttonLayout = new QToolBar();
-    auto addTileButton = [&](TileType type, const QString& iconPath) {
+    auto addTileButton = [&](TileType type) {
         auto* button = new QPushButton();
         button->setToolTip(QString::number(static_cast<int>(type)));
         buttonLayout->addWidget(button);
@@ -36,22 +82,21 @@ MainWindow::MainWindow(QWidget *parent)
             this->selectedTile = type;
             tileIconManager.updateButtonStyles(selectedTile);
         });
-        tileIconManager.registerButton(type, iconPath, button);
+        tileIconManager.registerButton(type, button);
     };
 
-    addTileButton(TileType::Air,      "data/sprites/air.png");
-    addTileButton(TileType::Wall,     "data/sprites/wall.png");
-    addTileButton(TileType::DarkWall, "data/sprites/wall_dark.png");
-    addTileButton(TileType::Coin,     "data/sprites/coin.png");
-    addTileButton(TileType::Spikes,   "data/sprites/spikes.png");
-    addTileButton(TileType::Enemy,    "data/sprites/enemy.png");
-    addTileButton(TileType::PlayerLeft,"data/sprites/player_left.png");
-    addTileButton(TileType::PlayerRight,"data/sprites/player_right.png");
-    addTileButton(TileType::PlayerUp, "data/sprites/player_up.png");
-    addTileButton(TileType::PlayerDown,"data/sprites/player_down.png");
-    addTileButton(TileType::Platform,"data/sprites/platform.png");
-    addTileButton(TileType::Spring,     "data/sprites/spring.png");
+    for (const TileInfo& info : tileTable) {
+        if (info.type != TileType::Exit) addTileButton(info.type);
+    }
     tileIconManager.updateButtonStyles(selectedTile);
+    buttonLayout->addSeparator();
+    auto* toolBox = new QComboBox();
+    toolBox->addItems({"Pencil", "Bucket fill", "Bucket fill (diagonal)", "Rectangle", "Rectangle outline", "Select"});
+    toolBox->setToolTip("Drawing tool");
+    connect(toolBox, &QComboBox::currentIndexChanged, this, [this](int index) { tool = static_cast<Tool>(index); });
+    buttonLayout->addWidget(toolBox);
+    buttonLayout->setIconSize(toolIconSize);
+    tileIconManager.scaleIcons(toolIconSize);
     mainLayout->addWidget(buttonLayout);
 
     dirWidget = new DirectionInputWidget(this);
@@ -64,8 +109,34 @@ MainWindow::MainWindow(QWidget *parent)
     dockWidget->setFeatures(QDockWidget::NoDockWidgetFeatures);
     addDockWidget(Qt::RightDockWidgetArea, dockWidget);
 
+    auto* overviewDock = new QDockWidget("Overview", this);
+    overviewDock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+    overviewDock->setWidget(new LevelMinimap(level));
+    addDockWidget(Qt::LeftDockWidgetArea, overviewDock);
+
+    auto* worldDock = new QDockWidget("World", this);
+    worldDock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+    worldDock->setWidget(worldPanel);
+    addDockWidget(Qt::LeftDockWidgetArea, worldDock);
+
+    auto* searchDock = new QDockWidget("Search", this);
+    searchDock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+    searchDock->setWidget(searchPanel);
+    tabifyDockWidget(worldDock, searchDock);
+    auto* changesDock = new QDockWidget("Changes", this);
+    changesDock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+    changesDock->setWidget(diffPanel);
+    tabifyDockWidget(searchDock, changesDock);
+    worldDock->raise();
+
     centralWidget->show();
     this->showMaximized();
+    QTimer::singleShot(0, this, [this] { offerRecovery(); });
+}
+
+void MainWindow::closeEvent(QCloseEvent *event) {
+    if (maybeSaveChanges()) event->accept();
+    else event->ignore();
 }
 
 void MainWindow::keyPressEvent(QKeyEvent *event) {
@@ -94,7 +165,25 @@ void MainWindow::keyPressEvent(QKeyEvent *event) {
         event->accept();
         return;}
     if (event->modifiers() & Qt::ControlModifier && event->key() == Qt::Key_C) {
-        clearLevel();
+        if (selection.isEmpty()) clearLevel();
+        else copySelection();
+        event->accept();
+        return;}
+    if (event->modifiers() & Qt::ControlModifier && event->key() == Qt::Key_X) {
+        cutSelection();
+        event->accept();
+        return;}
+    if (event->modifiers() & Qt::ControlModifier && event->key() == Qt::Key_V) {
+        startPaste();
+        event->accept();
+        return;}
+    if (event->modifiers() & Qt::ControlModifier && event->key() == Qt::Key_A) {
+        setSelection(QRect(0, 0, level->columnCount(), level->rowCount()));
+        event->accept();
+        return;}
+    if (event->key() == Qt::Key_Escape) {
+        if (pasting) cancelFloatingTiles();
+        else setSelection(QRect());
         event->accept();
         return;}
     if (event->modifiers() & Qt::ControlModifier && event->key() == Qt::Key_R) {
@@ -102,269 +191,376 @@ void MainWindow::keyPressEvent(QKeyEvent *event) {
         event->accept();
         return;}
     if (event->modifiers() & Qt::ControlModifier && event->key() == Qt::Key_Z) {
-        undoTilePlacement();
+        if (event->modifiers() & Qt::ShiftModifier) redoEdit();
+        else undoEdit();
+        event->accept();
+        return;}
+    if (event->modifiers() & Qt::ControlModifier && (event->key() == Qt::Key_Equal || event->key() == Qt::Key_Plus)) {
+        level->zoomBy(1.25);
+        event->accept();
+        return;}
+    if (event->modifiers() & Qt::ControlModifier && event->key() == Qt::Key_Minus) {
+        level->zoomBy(0.8);
+        event->accept();
+        return;}
+    if (event->modifiers() & Qt::ControlModifier && event->key() == Qt::Key_0) {
+        level->fitToView();
+        event->accept();
+        return;}
+    if (event->modifiers() & Qt::ControlModifier && event->modifiers() & Qt::ShiftModifier && event->key() == Qt::Key_P) {
+        level->setPerfOverlayVisible(!level->isPerfOverlayVisible());
+        event->accept();
+        return;}
+    if (event->modifiers() & Qt::ControlModifier && event->key() == Qt::Key_Y) {
+        redoEdit();
         event->accept();
         return;}
     QMainWindow::keyPressEvent(event);
 }
 
-void MainWindow::resizeEvent(QResizeEvent *event) {
-    QMainWindow::resizeEvent(event);
-    int rows = level->rowCount();
-    int columns = level->columnCount();
-    int cellSize = std::max(std::min(level->viewport()->width() / columns, level->viewport()->height() / rows), 25);
-    for (int row = 0; row < rows; ++row) level->setRowHeight(row, cellSize);
-    for (int col = 0; col < columns; ++col) level->setColumnWidth(col, cellSize);
-
-    QSize iconSize(cellSize, cellSize);
-    level->setIconSize(iconSize);
-    buttonLayout->setIconSize(iconSize);
-    tileIconManager.scaleIcons(iconSize);
-}
-
 bool MainWindow::eventFilter(QObject *obj, QEvent *event) {
     if (obj == level->viewport()) {
         if (event->type() == QEvent::MouseButtonPress) {
             auto *mouseEvent = dynamic_cast<QMouseEvent*>(event);
-            if (mouseEvent->button() == Qt::LeftButton) isDrawing = true;
+            if (mouseEvent->button() == Qt::LeftButton) {
+                lastCell = level->cellAt(mouseEvent->pos());
+                if (pasting) placeFloatingTiles(lastCell - floatingGrab, QRect());
+                else if (tool == Tool::Select && selection.contains(lastCell)) {
+                    isDrawing = true;
+                    movingSelection = true;
+                    floatingTiles = level->tiles().region(selection.top(), selection.left(), selection.height(), selection.width());
+                    floatingGrab = lastCell - selection.topLeft();
+                    level->setFloatingTiles(floatingTiles, selection.topLeft());
+                }
+                else if (tool == Tool::Bucket || tool == Tool::Bucket8) bucketFill(lastCell.y(), lastCell.x());
+                else if (tool == Tool::Pencil) {
+                    isDrawing = true;
+                    history.beginStroke();
+                    onTileClicked(lastCell.y(), lastCell.x());
+                }
+                else if (tool == Tool::Select) {
+                    isDrawing = true;
+                    toolAnchor = lastCell;
+                    setSelection(toolRect(toolAnchor, lastCell));
+                }
+                else {
+                    isDrawing = true;
+                    toolAnchor = lastCell;
+                    level->setToolPreview(toolRect(toolAnchor, lastCell));
+                }
+            }
         }
         else if (event->type() == QEvent::MouseMove) {
             auto *mouseEvent = dynamic_cast<QMouseEvent*>(event);
-            if (isDrawing) {
-                int row = level->rowAt(mouseEvent->pos().y());
-                int col = level->columnAt(mouseEvent->pos().x());
-                if (row != -1 && col != -1) onTileClicked(row, col);
+            const QPoint cell = level->cellAt(mouseEvent->pos());
+            if (pasting) level->moveFloatingTiles(cell - floatingGrab);
+            else if (isDrawing && cell != lastCell) {
+                if (movingSelection) level->moveFloatingTiles(cell - floatingGrab);
+                else if (tool == Tool::Select) setSelection(toolRect(toolAnchor, cell));
+                else if (tool == Tool::Pencil) {
+                    // Fill the cells a fast drag jumped over; the first one was painted by the previous event.
+                    forEachCellOnLine(lastCell.y(), lastCell.x(), cell.y(), cell.x(), [this](int row, int col) {
+                        if (row != lastCell.y() || col != lastCell.x()) onTileClicked(row, col);
+                    });
+                }
+                else level->setToolPreview(toolRect(toolAnchor, cell));
+                lastCell = cell;
             }
         }
         else if (event->type() == QEvent::MouseButtonRelease) {
             auto *mouseEvent = dynamic_cast<QMouseEvent*>(event);
-            if (mouseEvent->button() == Qt::LeftButton) isDrawing = false;
+            if (mouseEvent->button() == Qt::LeftButton && isDrawing) {
+                isDrawing = false;
+                if (tool == Tool::Pencil) history.endStroke();
+                else if (movingSelection) {
+                    movingSelection = false;
+                    placeFloatingTiles(lastCell - floatingGrab, selection);
+                }
+                else if (tool == Tool::Select) setSelection(toolRect(toolAnchor, lastCell));
+                else {
+                    level->setToolPreview(QRect());
+                    fillRect(toolRect(toolAnchor, lastCell), tool == Tool::Outline);
+                }
+            }
         }
     }
     return QMainWindow::eventFilter(obj, event);
 }
 
 void MainWindow::onTileClicked(int row, int col) {
-    QTableWidgetItem* item = level->item(row, col);
-    if (item == nullptr) {
-        item = new QTableWidgetItem();
-        level->setItem(row, col, item);
-    }
-
-    char currentChar = item->data(Qt::UserRole).toChar().toLatin1();
-    char targetChar = '-';
-    switch (selectedTile) {
-        case TileType::Air:        targetChar = '-'; break;
-        case TileType::Wall:       targetChar = '#'; break;
-        case TileType::DarkWall:   targetChar = '='; break;
-        case TileType::Coin:       targetChar = '*'; break;
-        case TileType::Spikes:     targetChar = '^'; break;
-        case TileType::Enemy:      targetChar = '&'; break;
-        case TileType::PlayerLeft: targetChar = 'L'; break;
-        case TileType::PlayerRight:targetChar = 'R'; break;
-        case TileType::PlayerUp:   targetChar = 'U'; break;
-        case TileType::PlayerDown: targetChar = 'D'; break;
-        case TileType::Platform:   targetChar = 'P'; break;
-        case TileType::Spring:     targetChar = 'S'; break;
-    }
+    if (!level->tiles().contains(row, col)) return;
+    char currentChar = level->tileAt(row, col);
+    char targetChar = TileIconManager::symbol(selectedTile);
     if (currentChar == targetChar) return;
 
-    item->setText(QString(1, targetChar));
-    item->setForeground(Qt::transparent);
-    TileAction action;
-    action.row = row;
-    action.col = col;
-    action.previousIcon = item->icon();
-    action.previousData = item->data(Qt::UserRole);
-    action.isEmpty = item->icon().isNull();
-    QSize iconSize = level->iconSize() * 0.95;
-    QIcon icon;
-    switch (selectedTile) {
-        case TileType::Air:        icon = TileIconManager::getScaledIcon("data/sprites/air.png", iconSize); break;
-        case TileType::Wall:       icon = TileIconManager::getScaledIcon("data/sprites/wall.png", iconSize); break;
-        case TileType::DarkWall:   icon = TileIconManager::getScaledIcon("data/sprites/wall_dark.png", iconSize); break;
-        case TileType::Coin:       icon = TileIconManager::getScaledIcon("data/sprites/coin.png", iconSize); break;
-        case TileType::Spikes:     icon = TileIconManager::getScaledIcon("data/sprites/spikes.png", iconSize); break;
-        case TileType::Enemy:      icon = TileIconManager::getScaledIcon("data/sprites/enemy.png", iconSize); break;
-        case TileType::PlayerLeft: icon = TileIconManager::getScaledIcon("data/sprites/player_left.png", iconSize); break;
-        case TileType::PlayerRight:icon = TileIconManager::getScaledIcon("data/sprites/player_right.png", iconSize); break;
-        case TileType::PlayerUp:   icon = TileIconManager::getScaledIcon("data/sprites/player_up.png", iconSize); break;
-        case TileType::PlayerDown: icon = TileIconManager::getScaledIcon("data/sprites/player_down.png", iconSize); break;
-        case TileType::Platform:   icon = TileIconManager::getScaledIcon("data/sprites/platform.png", iconSize); break;
-        case TileType::Spring:     icon = TileIconManager::getScaledIcon("data/sprites/spring.png", iconSize); break;
-    }
-    item->setIcon(icon);
-    item->setData(Qt::UserRole, targetChar);
-    undoStack.push(action);
+    history.record(level->tiles(), row, col, targetChar);
+    level->setTile(row, col, targetChar);
+}
+
+QRect MainWindow::toolRect(const QPoint& from, const QPoint& to) const {
+    return QRect(from, to).normalized().intersected(QRect(0, 0, level->columnCount(), level->rowCount()));
+}
+
+void MainWindow::setSelection(const QRect& cells) {
+    selection = cells;
+    level->setSelection(cells);
+}
+
+void MainWindow::copySelection() {
+    if (selection.isEmpty()) return;
+    copyTilesToClipboard(level->tiles().region(selection.top(), selection.left(), selection.height(), selection.width()));
+}
+
+void MainWindow::cutSelection() {
+    if (selection.isEmpty()) return;
+    copySelection();
+    history.beginStroke();
+    level->editTiles([&](TileMap& map) {
+        for (int row = selection.top(); row <= selection.bottom(); ++row) {
+            history.recordRow(map, row, selection.left(), selection.right(), TileMap::air);
+            map.fillRow(row, selection.left(), selection.width(), TileMap::air);
+        }
+        return selection;
+    });
+    history.endStroke();
+}
+
+void MainWindow::startPaste() {
+    TileMap tiles;
+    if (!tilesFromClipboard(tiles)) return;
+    cancelFloatingTiles();
+    floatingTiles = std::move(tiles);
+    floatingGrab = QPoint();
+    pasting = true;
+    const QPoint mouse = level->viewport()->mapFromGlobal(QCursor::pos());
+    const QPoint origin = level->viewport()->rect().contains(mouse) ? level->cellAt(mouse)
+                                                                   : level->visibleCells().topLeft().toPoint();
+    level->viewport()->setMouseTracking(true);
+    level->setFloatingTiles(floatingTiles, origin);
+}
+
+// Pastes the floating tiles at origin as one undo step, after clearing the cells they
+// were lifted from when moving.
+void MainWindow::placeFloatingTiles(const QPoint& origin, const QRect& cleared) {
+    const QRect target = QRect(origin, QSize(floatingTiles.columns(), floatingTiles.rows()));
+    history.beginStroke();
+    level->editTiles([&](TileMap& map) {
+        for (int row = cleared.top(); row <= cleared.bottom(); ++row) {
+            history.recordRow(map, row, cleared.left(), cleared.right(), TileMap::air);
+            map.fillRow(row, cleared.left(), cleared.width(), TileMap::air);
+        }
+        history.recordPaste(map, floatingTiles, origin.y(), origin.x());
+        map.paste(floatingTiles, origin.y(), origin.x());
+        return (cleared | target) & QRect(0, 0, map.columns(), map.rows());
+    });
+    history.endStroke();
+    cancelFloatingTiles();
+    setSelection(toolRect(target.topLeft(), target.bottomRight()));
+}
+
+void MainWindow::cancelFloatingTiles() {
+    pasting = false;
+    movingSelection = false;
+    floatingTiles = TileMap();
+    level->viewport()->setMouseTracking(false);
+    level->setFloatingTiles(TileMap(), QPoint());
+}
+
+void MainWindow::bucketFill(int row, int col) {
+    if (!level->tiles().contains(row, col)) return;
+    const char tile = TileIconManager::symbol(selectedTile);
+    history.beginStroke();
+    level->editTiles([&](TileMap& map) {
+        QRect bounds;
+        floodFill(map, row, col, tile, tool == Tool::Bucket8, [&](int spanRow, int first, int last) {
+            history.recordRow(map, spanRow, first, last, tile);
+            bounds |= QRect(first, spanRow, last - first + 1, 1);
+        });
+        return bounds;
+    });
+    history.endStroke();
+}
+
+void MainWindow::fillRect(const QRect& cells, bool outline) {
+    if (cells.isEmpty()) return;
+    const char tile = TileIconManager::symbol(selectedTile);
+    history.beginStroke();
+    level->editTiles([&](TileMap& map) {
+        for (int row = cells.top(); row <= cells.bottom(); ++row) {
+            const bool edge = row == cells.top() || row == cells.bottom();
+            const auto span = [&](int first, int last) {
+                history.recordRow(map, row, first, last, tile);
+                map.fillRow(row, first, last - first + 1, tile);
+            };
+            if (!outline || edge) span(cells.left(), cells.right());
+            else {
+                span(cells.left(), cells.left());
+                span(cells.right(), cells.right());
+            }
+        }
+        return cells;
+    });
+    history.endStroke();
 }
 
 void MainWindow::saveLevel() {
+    TRACE_SCOPE("MainWindow::saveLevel");
     int rows = level->rowCount();
     int cols = level->columnCount();
-    std::vector<char> data(rows * cols, '-');
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            QTableWidgetItem* item = level->item(i, j);
-            if (item) {
-                QVariant var = item->data(Qt::UserRole);
-                char symbol = '-';
-                if (var.isValid() && !var.isNull()) {
-                    QChar ch = var.toChar();
-                    if (!ch.isNull()) symbol = ch.toLatin1();
-                }
-                data[i * cols + j] = symbol;
-            }
-        }
-    }
-    QString encryptedData;
+    QByteArray encryptedData;
     dirWidget->getValues(next_level);
-    encrypt(rows, cols, data, next_level, encryptedData);
-
-    if (QListWidgetItem* currentItem = levelListWidget->currentItem()) {
-        currentItem->setData(Qt::UserRole, encryptedData);
-        QFile file("data/saves/levels.rll");
-        if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-            QTextStream out(&file);
-            for (int i = 0; i < levelListWidget->count(); ++i) {
-                QListWidgetItem* item = levelListWidget->item(i);
-                QString levelName = item->text();
-                QString levelData = item->data(Qt::UserRole).toString();
-                out << "; " << levelName << "\n";
-                out << levelData << "\n";
-            }
-            file.close();
-        }
+    encrypt(rows, cols, level->tiles().toVector(), next_level, encryptedData);
+
+    int index = currentLevelIndex();
+    if (index >= 0) {
+        levelModel->setLevel(index, std::move(encryptedData));
+        worldAnalyzer.levelChanged(levelModel->pack(), index);
     }
     else {
-        int nextIndex = levelListWidget->count() + 1;
-        QString levelName = QString("Level %1").arg(nextIndex);
-        auto* newItem = new QListWidgetItem(levelName);
-        newItem->setData(Qt::UserRole, encryptedData);
-        levelListWidget->addItem(newItem);
-        levelListWidget->setCurrentItem(newItem);
-        QFile file("data/saves/levels.rll");
-        if (file.open(QIODevice::Append | QIODevice::Text)) {
-            QTextStream out(&file);
-            out << "\n; " << levelName << "\n";
-            out << encryptedData << "\n";
-            file.close();
-        }
+        index = levelModel->appendLevel(levelModel->pack().count() + 1, std::move(encryptedData));
+        selectLevel(index);
+        worldAnalyzer.reset(levelModel->pack());
     }
-    undoStack.clear();
+    levelModel->pack().save();
+    editedIndex = index;
+    autoSaver.markClean();
 }
 
 void MainWindow::newLevel() {
+    if (!maybeSaveChanges()) return;
     int rows = level->rowCount();
     int cols = level->columnCount();
-    int maxNumber = 0;
-    for (int i = 0; i < levelListWidget->count(); ++i) {
-        QListWidgetItem* item = levelListWidget->item(i);
-        QString text = item->text();
-        QRegularExpression re("Level (\\d+)");
-        if (QRegularExpressionMatch match = re.match(text); match.hasMatch()) {
-            int num = match.captured(1).toInt();
-            maxNumber = std::max(maxNumber, num);
-        }
-    }
-    int newLevelNumber = maxNumber + 1;
-    QString newLevelName = QString("Level %1").arg(newLevelNumber);
+    int newLevelNumber = levelModel->pack().maxNumber() + 1;
     std::vector<char> emptyData(rows * cols, '-');
-    QString encrypted;
+    QByteArray encrypted;
     dirWidget->getValues(next_level);
     encrypt(rows, cols, emptyData, next_level, encrypted);
 
-    auto* newItem = new QListWidgetItem(newLevelName);
-    newItem->setData(Qt::UserRole, encrypted);
-    levelListWidget->addItem(newItem);
-    levelListWidget->setCurrentItem(newItem);
+    int index = levelModel->appendLevel(newLevelNumber, std::move(encrypted));
+    selectLevel(index);
+    worldAnalyzer.reset(levelModel->pack());
     for (int & i : next_level) i = 0;
-    parseLevel(encrypted);
+    parseLevel(index);
 }
 
 void MainWindow::deleteLevel() {
-    QListWidgetItem* selectedItem = levelListWidget->currentItem();
-    if (!selectedItem) {
+    int index = currentLevelIndex();
+    if (index < 0) {
         QMessageBox::information(this, "Info", "No level selected to delete.");
         return;
     }
     QMessageBox::StandardButton reply = QMessageBox::question(this, "Delete Level", "Are you sure you want to delete this level?",
                                                               QMessageBox::Yes | QMessageBox::No);
     if (reply == QMessageBox::No) return;
-    int row = levelListWidget->row(selectedItem);
-    delete levelListWidget->takeItem(row);
-    QFile file("data/saves/levels.rll");
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
-        QMessageBox::warning(this, "Error", "Unable to update file.");
-        return;
+    levelModel->removeLevel(index);
+    levelModel->pack().save();
+    worldAnalyzer.reset(levelModel->pack());
+    if (index == editedIndex) {
+        editedIndex = -1;
+        autoSaver.markClean();
     }
-    QTextStream out(&file);
-    for (int i = 0; i < levelListWidget->count(); ++i) {
-        QListWidgetItem* item = levelListWidget->item(i);
-        out << "\n; Level " << (i + 1) << "\n";
-        out << item->data(Qt::UserRole).toString() << "\n";
-        item->setText(QString("Level %1").arg(i + 1));
-    }
-    file.close();
+    else if (index < editedIndex) --editedIndex;
 }
 
 void MainWindow::importFromFile() {
-    QString sourcePath = QFileDialog::getOpenFileName(
+    if (!maybeSaveChanges()) return;
+    const QString sourcePath = QFileDialog::getOpenFileName(
         this,
         "Select File to Import",
         QDir::homePath(),
-        "RLL Files (*.rll);;All Files (*)"
+        "Level Packs (*.rll *.rlb);;All Files (*)"
     );
-    if (sourcePath.isEmpty() || !QFile::exists(sourcePath)) {
-        QMessageBox::warning(this, "Error", "Selected file does not exist.");
-        return;
-    }
-    QFileInfo fileInfo(sourcePath);
-    QString fileName = fileInfo.fileName();
-    QString destinationDir = QDir::currentPath() + "/data/saves";
-    QString destinationPath = QDir(destinationDir).filePath(fileName);
-
-    if (QFile::exists(destinationPath)) {
-        auto reply = QMessageBox::question(
-            this, "Overwrite?", "File already exists in data/saves/. Overwrite?",
-            QMessageBox::Yes | QMessageBox::No
-        );
-        if (reply != QMessageBox::Yes) return;
-        QFile::remove(destinationPath);
-    }
-    if (!QFile::copy(sourcePath, destinationPath)) QMessageBox::critical(this, "Error", "Failed to import the file.");
-    else QMessageBox::information(this, "Success", "File imported successfully to:\n" + destinationPath);
-    loadLevelListFromFile("data/saves/levels.rll");
+    if (sourcePath.isEmpty()) return;
+    LevelPack& pack = levelModel->pack();
+    pack.compact();
+    importing = true;
+    showTransferProgress("Importing " + QFileInfo(sourcePath).fileName() + "...");
+    packTransfer.startImport(pack.path(), sourcePath, pack.path() + ".import", [&pack] { pack.waitForWrites(); });
 }
 
 void MainWindow::exportToFile() {
-    QString sourceDir = QDir::currentPath() + "/data/saves";
-    QString sourcePath = QFileDialog::getOpenFileName(
-        this, "Select File to Export from data/saves",
-        sourceDir, "RLL Files (*.rll);;All Files (*)"
+    LevelPack& pack = levelModel->pack();
+    QString selectedFilter;
+    QString destinationPath = QFileDialog::getSaveFileName(
+        this, "Export Level Pack",
+        QDir(QDir::homePath()).filePath(QFileInfo(pack.path()).completeBaseName()),
+        "RLL Files (*.rll);;RLB Files (*.rlb);;RLB Files with shared rows (*.rlb)", &selectedFilter
     );
-    if (sourcePath.isEmpty() || !QFile::exists(sourcePath)) {
-        QMessageBox::warning(this, "Error", "Selected file does not exist.");
-        return;
+    if (destinationPath.isEmpty()) return;
+    const QString suffix = selectedFilter.startsWith("RLB") ? ".rlb" : ".rll";
+    if (QFileInfo(destinationPath).suffix().isEmpty()) destinationPath += suffix;
+    pack.compact();
+    importing = false;
+    showTransferProgress("Exporting to " + QFileInfo(destinationPath).fileName() + "...");
+    packTransfer.startExport(pack.path(), destinationPath, selectedFilter.contains("shared rows"),
+                             [&pack] { pack.waitForWrites(); });
+}
+
+// Window-modal, so the pack cannot be edited while a job reads it.
+void MainWindow::showTransferProgress(const QString& label) {
+    transferProgress = new QProgressDialog(label, "Cancel", 0, 100, this);
+    transferProgress->setWindowModality(Qt::WindowModal);
+    transferProgress->setMinimumDuration(0);
+    transferProgress->setAutoClose(false);
+    transferProgress->setAutoReset(false);
+    connect(transferProgress, &QProgressDialog::canceled, this, [this] {
+        packTransfer.cancel();
+        closeTransferProgress();
+    });
+    transferProgress->setValue(0);
+}
+
+void MainWindow::closeTransferProgress() {
+    if (!transferProgress) return;
+    transferProgress->deleteLater();
+    transferProgress = nullptr;
+}
+
+void MainWindow::transferFinished(const PackTransfer::Result& result) {
+    closeTransferProgress();
+    QStringList badRecords;
+    for (const PackTransfer::BadRecord& bad : result.badRecords) {
+        badRecords << (bad.line > 0 ? QString("Level %1, line %2, column %3: %4").arg(bad.number).arg(bad.line).arg(bad.column).arg(bad.message)
+                                    : QString("Level %1, byte %2: %3").arg(bad.number).arg(bad.column).arg(bad.message));
     }
-    QString targetDir = QFileDialog::getExistingDirectory(
-        this,
-        "Select Target Directory",
-        QDir::homePath()
-    );
-    if (targetDir.isEmpty()) return;
-    QFileInfo fileInfo(sourcePath);
-    QString fileName = fileInfo.fileName();
-    QString destinationPath = QDir(targetDir).filePath(fileName);
-    if (QFile::exists(destinationPath)) {
-        auto reply = QMessageBox::question(
-            this, "Overwrite?", "File already exists in the target directory. Overwrite?",
-            QMessageBox::Yes | QMessageBox::No
-        );
-        if (reply != QMessageBox::Yes) return;
-        QFile::remove(destinationPath);
+    if (result.badRecordCount > static_cast<int>(badRecords.size()))
+        badRecords << QString("... and %1 more").arg(result.badRecordCount - badRecords.size());
+
+    QString text;
+    QMessageBox::Icon icon = QMessageBox::Information;
+    if (!result.error.isEmpty()) {
+        icon = QMessageBox::Critical;
+        text = QString("Failed to %1 the file:\n%2").arg(importing ? "import" : "export", result.error);
+    }
+    else if (importing) {
+        // The merged copy replaces the pack only once the pack has let go of the file.
+        LevelPack& pack = levelModel->pack();
+        const QString packPath = pack.path();
+        cancelPackJobs();
+        pack.close();
+        std::error_code error;
+        std::filesystem::rename(std::filesystem::path(result.path.toStdU16String()),
+                                std::filesystem::path(packPath.toStdU16String()), error);
+        loadLevelListFromFile(packPath);
+        if (error) {
+            icon = QMessageBox::Critical;
+            text = QString("Failed to replace %1:\n%2").arg(packPath, QString::fromStdString(error.message()));
+        }
+        else {
+            text = QString("Imported %1 levels (%2 s).").arg(result.levels).arg(result.milliseconds / 1000.0, 0, 'f', 1);
+            if (result.duplicates > 0) text += QString("\n%1 levels were already in the pack and were skipped.").arg(result.duplicates);
+            if (result.renumbered > 0) text += QString("\n%1 levels got new numbers because theirs were taken.").arg(result.renumbered);
+        }
     }
-    if (!QFile::copy(sourcePath, destinationPath)) QMessageBox::critical(this, "Error", "Failed to export the file.");
-    else QMessageBox::information(this, "Success", "File exported successfully to:\n" + destinationPath);
+    else text = QString("File exported successfully to:\n%1").arg(result.path);
+    if (result.badRecordCount > 0) {
+        if (icon == QMessageBox::Information) icon = QMessageBox::Warning;
+        text += QString("\n%1 levels could not be read; see the details.").arg(result.badRecordCount);
+    }
+
+    QMessageBox box(icon, importing ? "Import" : "Export", text, QMessageBox::Ok, this);
+    if (!badRecords.isEmpty()) box.setDetailedText(badRecords.join('\n'));
+    box.exec();
 }
 
 void MainWindow::helpDialog() {
@@ -392,56 +588,24 @@ void MainWindow::helpDialog() {
 void MainWindow::clearLevel() {
     QMessageBox::StandardButton reply = QMessageBox::question(this, "Clear Level", "Are you sure you want to clear the level?",
                                                               QMessageBox::Yes | QMessageBox::No);
-    if (reply == QMessageBox::Yes) {
-        int rows = level->rowCount();
-        int columns = level->columnCount();
-        QSize iconSize = level->iconSize() * 0.95;
-        QIcon airIcon = TileIconManager::getScaledIcon("data/sprites/air.png", iconSize);
-        for (int row = 0; row < rows; ++row) {
-            for (int col = 0; col < columns; ++col) {
-                QTableWidgetItem* item = level->item(row, col);
-                if (!item) {
-                    item = new QTableWidgetItem();
-                    level->setItem(row, col, item);
-                }
-                item->setIcon(airIcon);
-                item->setData(Qt::UserRole, '-');
-                item->setText("-");
-                item->setForeground(Qt::transparent);
-            }
-        }
-    }
+    if (reply != QMessageBox::Yes) return;
+    history.recordFill(level->tiles(), '-');
+    level->fillTiles('-');
 }
 
 void MainWindow::resizeLevel(int newWidth, int newHeight) {
-    level->setRowCount(newHeight);
-    level->setColumnCount(newWidth);
-    int cellSize = std::min(level->viewport()->width() / newWidth, level->viewport()->height() / newHeight);
-    for (int row = 0; row < newHeight; ++row) level->setRowHeight(row, cellSize);
-    for (int col = 0; col < newWidth; ++col) level->setColumnWidth(col, cellSize);
-    QSize newSize(newWidth * cellSize, newHeight * cellSize);
-    QResizeEvent event(newSize, size());
-    resizeEvent(&event);
-}
-
-void MainWindow::undoTilePlacement() {
-    if (undoStack.isEmpty()) return;
-    TileAction action = undoStack.pop();
-
-    QTableWidgetItem* item = level->item(action.row, action.col);
-    if (item == nullptr) {
-        item = new QTableWidgetItem();
-        level->setItem(action.row, action.col, item);
-    }
+    level->resizeTiles(newHeight, newWidth);
+    history.clear();
+    setSelection(QRect());
+    level->fitToView();
+}
 
-    if (action.isEmpty) {
-        item->setIcon(QIcon());
-        item->setData(Qt::UserRole, QString('-'));
-    }
-    else {
-        item->setIcon(action.previousIcon);
-        item->setData(Qt::UserRole, action.previousData);
-    }
+void MainWindow::undoEdit() {
+    if (history.canUndo()) level->editTiles([this](TileMap& map) { history.undo(map); });
+}
+
+void MainWindow::redoEdit() {
+    if (history.canRedo()) level->editTiles([this](TileMap& map) { history.redo(map); });
 }
 
 void MainWindow::resizeDialog() {
@@ -469,58 +633,44 @@ void MainWindow::resizeDialog() {
     resizeDialog.exec();
 }
 
-void MainWindow::parseLevel(const QString& encryptedData) {
-    int rows, cols;
-    std::vector<char> data;
-    dirWidget->getValues(next_level);
-    if (!decrypt(encryptedData, rows, cols, next_level, data)) {
-        QMessageBox::warning(this, "Error", "Can't decode level");
+void MainWindow::parseLevel(int index) {
+    TRACE_SCOPE("MainWindow::parseLevel");
+    rle::Level decoded;
+    if (rle::Error error = levelModel->pack().read(index, decoded)) {
+        QMessageBox::warning(this, "Error", QString("Can't decode level: %1").arg(QString::fromStdString(rle::describe(error))));
         return;
     }
+    for (int i = 0; i < 4; ++i) next_level[i] = decoded.nextLevel[i];
     dirWidget->setNextLevel(next_level);
-    level->setRowCount(rows);
-    level->setColumnCount(cols);
-    resizeLevel(cols, rows);
-
-    const QSize iconSize = level->iconSize() * 0.95;
-    for (int i = 0; i < rows; ++i) {
-        for (int j = 0; j < cols; ++j) {
-            QChar ch = data[i * cols + j];
-            auto* item = new QTableWidgetItem();
-            item->setTextAlignment(Qt::AlignCenter);
-            QIcon icon;
-            switch (ch.toLatin1()) {
-                case '-':   icon = TileIconManager::getScaledIcon("data/sprites/air.png", iconSize); break;
-                case '#':   icon = TileIconManager::getScaledIcon("data/sprites/wall.png", iconSize); break;
-                case '=':   icon = TileIconManager::getScaledIcon("data/sprites/wall_dark.png", iconSize); break;
-                case '*':   icon = TileIconManager::getScaledIcon("data/sprites/coin.png", iconSize); break;
-                case '^':   icon = TileIconManager::getScaledIcon("data/sprites/spikes.png", iconSize); break;
-                case '&':   icon = TileIconManager::getScaledIcon("data/sprites/enemy.png", iconSize); break;
-                case 'E':   icon = TileIconManager::getScaledIcon("data/sprites/exit.png", iconSize); break;
-                case 'L':   icon = TileIconManager::getScaledIcon("data/sprites/player_left.png", iconSize); break;
-                case 'R':   icon = TileIconManager::getScaledIcon("data/sprites/player_right.png", iconSize); break;
-                case 'U':   icon = TileIconManager::getScaledIcon("data/sprites/player_up.png", iconSize); break;
-                case 'D':   icon = TileIconManager::getScaledIcon("data/sprites/player_down.png", iconSize); break;
-                case 'P':   icon = TileIconManager::getScaledIcon("data/sprites/platform.png", iconSize); break;
-                case 'S':   icon = TileIconManager::getScaledIcon("data/sprites/spring.png", iconSize); break;
-                default:    icon = QIcon();
-            }
-            item->setData(Qt::UserRole, ch);
-            item->setIcon(icon);
-            level->setItem(i, j, item);
-        }
-    }
+    hideDiffOverlay();
+    level->setTiles(TileMap(decoded.rows, decoded.columns, std::move(decoded.tiles)));
+    history.clear();
+    setSelection(QRect());
+    level->fitToView();
+    editedIndex = index;
+    autoSaver.markClean();
 }
 
 QWidget* MainWindow::createActionButtons() {
     auto* container = new QWidget;
     auto* layout = new QVBoxLayout(container);
-    levelListWidget = new QListWidget;
+    levelModel = new LevelListModel(this);
+    levelListWidget = new QListView;
+    levelListWidget->setModel(levelModel);
+    levelListWidget->setUniformItemSizes(true);
+    levelListWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    levelModel->pack().setErrorHandler(levelModel, [this](const QString& message) {
+        QMessageBox::warning(this, "Error", message);
+    });
     layout->addWidget(new QLabel("Levels:"));
     layout->addWidget(levelListWidget, 1);
-    connect(levelListWidget, &QListWidget::itemClicked, this, [this](const QListWidgetItem* item) {
-        QString levelData = item->data(Qt::UserRole).toString();
-        parseLevel(levelData);
+    connect(levelListWidget, &QListView::clicked, this, [this](const QModelIndex& index) {
+        if (index.row() == editedIndex && autoSaver.isDirty()) return;
+        if (!maybeSaveChanges()) {
+            selectLevel(editedIndex);
+            return;
+        }
+        parseLevel(index.row());
     });
 
     auto* topPanel = new QWidget;
@@ -539,7 +689,20 @@ QWidget* MainWindow::createActionButtons() {
     auto* bottomLayout = new QVBoxLayout(bottomPanel);
     auto* clearButton = new QPushButton("Clear level");connect(clearButton, &QPushButton::clicked, this, &MainWindow::clearLevel);bottomLayout->addWidget(clearButton);
     auto* resizeButton = new QPushButton("Resize level");connect(resizeButton, &QPushButton::clicked, this, &MainWindow::resizeDialog);bottomLayout->addWidget(resizeButton);
-    auto* undoButton = new QPushButton("Undo");connect(undoButton, &QPushButton::clicked, this, &MainWindow::undoTilePlacement);bottomLayout->addWidget(undoButton);
+    auto* undoButton = new QPushButton("Undo");connect(undoButton, &QPushButton::clicked, this, &MainWindow::undoEdit);bottomLayout->addWidget(undoButton);
+    auto* redoButton = new QPushButton("Redo");connect(redoButton, &QPushButton::clicked, this, &MainWindow::redoEdit);bottomLayout->addWidget(redoButton);
+    auto* reachButton = new QPushButton("Reachability");
+    reachButton->setCheckable(true);
+    reachButton->setToolTip("Shade the cells the player can reach from the spawn tiles");
+    connect(reachButton, &QPushButton::toggled, this, &MainWindow::showReachability);
+    bottomLayout->addWidget(reachButton);
+    autosaveLabel = new QLabel;
+    autosaveLabel->setWordWrap(true);
+    bottomLayout->addWidget(autosaveLabel);
+    reachLabel = new QLabel;
+    reachLabel->setWordWrap(true);
+    reachLabel->hide();
+    bottomLayout->addWidget(reachLabel);
     layout->addWidget(bottomPanel);
 
     if (const QDir dir; !dir.exists("data/saves")) dir.mkpath("data/saves");
@@ -547,28 +710,216 @@ QWidget* MainWindow::createActionButtons() {
     return container;
 }
 
-void MainWindow::loadLevelListFromFile(const QString& path) const {
-    QFile file(path);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) qWarning() << "Cannot create level file:" << path;
-    QTextStream in(&file);
-    QString currentLevelName;
-    QStringList currentLevelData;
-    while (!in.atEnd()) {
-        if (QString line = in.readLine().trimmed(); line.startsWith("; Level")) {
-            if (!currentLevelName.isEmpty()) {
-                auto* item = new QListWidgetItem(currentLevelName);
-                item->setData(Qt::UserRole, currentLevelData.join("|"));
-                levelListWidget->addItem(item);
-                currentLevelData.clear();
-            }
-            currentLevelName = line.mid(2).trimmed();
+void MainWindow::loadLevelListFromFile(const QString& path) {
+    TRACE_SCOPE("MainWindow::loadLevelListFromFile");
+    cancelPackJobs();
+    if (!levelModel->load(path)) qWarning() << "Cannot open level file:" << path << levelModel->pack().errorString();
+    autoSaver.setPath(path + ".recovery");
+    if (editedIndex >= levelModel->pack().count()) editedIndex = -1;
+    worldAnalyzer.reset(levelModel->pack());
+    searchPanel->reset();
+    comparison.reset();
+    hideDiffOverlay();
+    diffPanel->reset();
+}
+
+void MainWindow::cancelPackJobs() {
+    worldAnalyzer.cancel();
+    patternSearch.cancel();
+    packComparer.cancel();
+}
+
+int MainWindow::currentLevelIndex() const {
+    QModelIndex index = levelListWidget->currentIndex();
+    return index.isValid() ? index.row() : -1;
+}
+
+void MainWindow::selectLevel(int index) {
+    levelListWidget->setCurrentIndex(levelModel->index(index));
+}
+
+void MainWindow::showReachability(bool show) {
+    reachVisible = show;
+    reachLabel->setVisible(show);
+    if (show) {
+        diffVisible = false;
+        reachLabel->setText("Analyzing...");
+        reachAnalyzer.setTiles(level->tiles());
+        return;
+    }
+    reachAnalyzer.cancel();
+    level->setOverlay(QImage());
+}
+
+void MainWindow::showReachSummary(const Reachability::Summary& summary) {
+    if (summary.spawns == 0) {
+        reachLabel->setText("No spawn tile to start from.");
+        return;
+    }
+    QStringList exits;
+    const char* exitNames[] = {"left", "right", "up", "down", "exit tile"};
+    for (int i = 0; i < 5; ++i) {
+        if (summary.exits & 1u << i) exits << exitNames[i];
+    }
+    reachLabel->setText(QString("Reachable cells: %1\nCoins: %2 of %3\nExits: %4%5")
+                            .arg(summary.reachableCells).arg(summary.reachableCoins).arg(summary.coins)
+                            .arg(exits.isEmpty() ? "none, the level cannot be finished" : exits.join(", "))
+                            .arg(summary.hazards ? QString("\nHazards in reach: %1").arg(summary.hazards) : QString()));
+}
+
+bool MainWindow::maybeSaveChanges() {
+    if (!autoSaver.isDirty()) return true;
+    const QString name = editedIndex >= 0 ? levelModel->pack().name(editedIndex) : QString("the new level");
+    const auto reply = QMessageBox::question(this, "Unsaved Changes", QString("Save the changes to %1?").arg(name),
+                                             QMessageBox::Save | QMessageBox::Discard | QMessageBox::Cancel);
+    if (reply == QMessageBox::Cancel) return false;
+    if (reply == QMessageBox::Save) {
+        selectLevel(editedIndex);
+        saveLevel();
+    }
+    else autoSaver.markClean();
+    return true;
+}
+
+void MainWindow::offerRecovery() {
+    const QString path = levelModel->pack().path() + ".recovery";
+    if (!QFile::exists(path)) return;
+    int number = 0;
+    rle::Level recovered;
+    if (!AutoSaver::readRecovery(path, number, recovered)) {
+        qWarning() << "Discarding unreadable recovery file" << path;
+        QFile::remove(path);
+        return;
+    }
+    const QString name = number > 0 ? QString("Level %1").arg(number) : QString("a new level");
+    const auto reply = QMessageBox::question(this, "Restore Unsaved Changes",
+        QString("The editor was closed with unsaved changes to %1, autosaved at %2. Restore them?")
+            .arg(name, QFileInfo(path).lastModified().toString("yyyy-MM-dd hh:mm:ss")),
+        QMessageBox::Yes | QMessageBox::No);
+    if (reply != QMessageBox::Yes) {
+        QFile::remove(path);
+        return;
+    }
+
+    const LevelPack& pack = levelModel->pack();
+    int index = -1;
+    for (int i = 0; i < pack.count() && number > 0; ++i) {
+        if (pack.number(i) == number) index = i;
+    }
+    if (index >= 0) parseLevel(index);
+    editedIndex = index;
+    selectLevel(index);
+    for (int i = 0; i < 4; ++i) next_level[i] = recovered.nextLevel[i];
+    dirWidget->setNextLevel(next_level);
+    level->setTiles(TileMap(recovered.rows, recovered.columns, std::move(recovered.tiles)));
+    history.clear();
+    level->fitToView();
+    autoSaver.markDirty();
+    autoSaver.saveNow();
+}
+
+void MainWindow::updateAutosaveStatus() {
+    autosaveLabel->setText(QString("Autosaved at %1 (snapshot took %2 µs, at most %3 µs)")
+                               .arg(QTime::currentTime().toString("hh:mm:ss"))
+                               .arg(autoSaver.lastSnapshotNanoseconds() / 1000.0, 0, 'f', 1)
+                               .arg(autoSaver.maxSnapshotNanoseconds() / 1000.0, 0, 'f', 1));
+}
+
+void MainWindow::showWorldLevel(int number) {
+    const LevelPack& pack = levelModel->pack();
+    for (int i = 0; i < pack.count(); ++i) {
+        if (pack.number(i) != number) continue;
+        if (i != editedIndex && !maybeSaveChanges()) return;
+        selectLevel(i);
+        parseLevel(i);
+        return;
+    }
+}
+
+void MainWindow::showSearchMatch(int number, const QRect& cells) {
+    const LevelPack& pack = levelModel->pack();
+    // Reopening the level on the canvas would throw away its unsaved edits.
+    if (editedIndex < 0 || pack.number(editedIndex) != number) {
+        showWorldLevel(number);
+        if (editedIndex < 0 || pack.number(editedIndex) != number) return;
+    }
+    const QRect target = cells & QRect(0, 0, level->columnCount(), level->rowCount());
+    if (target.isEmpty()) return;
+    setSelection(target);
+    level->setZoom(std::max(level->zoom(), LevelCanvas::gridZoom), level->viewport()->rect().center());
+    level->centerOn(QRectF(target).center());
+}
+
+QString MainWindow::selectionText() const {
+    if (selection.isEmpty()) return {};
+    QStringList rows;
+    std::string row(static_cast<size_t>(selection.width()), TileMap::air);
+    for (int r = selection.top(); r <= selection.bottom(); ++r) {
+        level->tiles().readRow(r, selection.left(), selection.width(), row.data());
+        rows << QString::fromStdString(row);
+    }
+    return rows.join('\n');
+}
+
+void MainWindow::showChange(int index) {
+    if (!comparison || index < 0 || static_cast<size_t>(index) >= comparison->diff.levels.size()) return;
+    const packdiff::LevelDiff& change = comparison->diff.levels[static_cast<size_t>(index)];
+    // Removed levels exist only in the other pack; there is nothing to open.
+    if (change.after < 0) return;
+    const LevelPack& pack = levelModel->pack();
+    if (editedIndex < 0 || pack.number(editedIndex) != change.afterNumber) {
+        showWorldLevel(change.afterNumber);
+        if (editedIndex < 0 || pack.number(editedIndex) != change.afterNumber) return;
+    }
+
+    // Against the canvas rather than the saved level, so unsaved edits are shaded too.
+    const std::string_view before = change.before >= 0 ? comparison->other.levels[static_cast<size_t>(change.before)].text
+                                                       : std::string_view();
+    diffBase = rle::Level();
+    if (!before.empty() && rle::decode(before, diffBase)) return;
+    std::string current;
+    rle::encode(level->tiles().toVector().data(), level->rowCount(), level->columnCount(), next_level, current);
+    packdiff::CellDiff cells;
+    if (packdiff::diffCells(before, current, cells)) return;
+
+    // Changed cells in magenta, cells the other version does not have in green.
+    const QRgb colors[] = {0, changedCellColor, qPremultiply(qRgba(0, 200, 80, 110))};
+    diffOverlay = QImage(cells.columns, cells.rows, QImage::Format_ARGB32_Premultiplied);
+    diffOverlay.fill(Qt::transparent);
+    for (int r = 0; r < cells.rows; ++r) {
+        auto* pixels = reinterpret_cast<QRgb*>(diffOverlay.scanLine(r));
+        const uint8_t* changed = cells.changed.data() + static_cast<size_t>(r) * cells.columns;
+        for (int c = 0; c < cells.columns; ++c) {
+            if (changed[c]) pixels[c] = colors[changed[c]];
         }
-        else if (!line.isEmpty()) currentLevelData << line;
     }
-    if (!currentLevelName.isEmpty()) {
-        auto* item = new QListWidgetItem(currentLevelName);
-        item->setData(Qt::UserRole, currentLevelData.join("|"));
-        levelListWidget->addItem(item);
+    diffVisible = true;
+    level->setOverlay(diffOverlay);
+}
+
+void MainWindow::updateDiffOverlay(const QRect& cells) {
+    if (diffOverlay.size() != QSize(level->columnCount(), level->rowCount())) {
+        hideDiffOverlay();
+        return;
     }
+    const QRect bounds = cells & diffOverlay.rect();
+    std::string row(static_cast<size_t>(bounds.width()), TileMap::air);
+    for (int r = bounds.top(); r <= bounds.bottom(); ++r) {
+        level->tiles().readRow(r, bounds.left(), bounds.width(), row.data());
+        auto* pixels = reinterpret_cast<QRgb*>(diffOverlay.scanLine(r));
+        for (int c = bounds.left(); c <= bounds.right(); ++c) {
+            if (r >= diffBase.rows || c >= diffBase.columns) continue;
+            const bool changed = diffBase.tiles[static_cast<size_t>(r) * diffBase.columns + c] != row[c - bounds.left()];
+            pixels[c] = changed ? changedCellColor : 0;
+        }
+    }
+    level->setOverlay(diffOverlay);
 }
 
+void MainWindow::hideDiffOverlay() {
+    if (!diffVisible) return;
+    diffVisible = false;
+    diffOverlay = QImage();
+    level->setOverlay(QImage());
+    if (reachVisible) reachAnalyzer.setTiles(level->tiles());
+}
@@ -3,7 +3,20 @@
 
 #include <QtWidgets>
 #include "TileIconManager.h"
+#include "AutoSaver.h"
+#include "DiffPanel.h"
 #include "DirectionInputWidget.h"
+#include "EditHistory.h"
+#include "LevelCanvas.h"
+#include "LevelListModel.h"
+#include "LevelMinimap.h"
+#include "PackComparer.h"
+#include "PackTransfer.h"
+#include "PatternSearch.h"
+#include "ReachAnalyzer.h"
+#include "SearchPanel.h"
+#include "WorldAnalyzer.h"
+#include "WorldPanel.h"
 
 class MainWindow : public QMainWindow
 {
@@ -14,44 +27,112 @@ public:
 
 protected:
     void keyPressEvent(QKeyEvent *event) override;
-    void resizeEvent(QResizeEvent *event) override;
+    void closeEvent(QCloseEvent *event) override;
     bool eventFilter(QObject *obj, QEvent *event) override;
 
 private:
+    // In the order of the tool selector.
+    enum class Tool {
+        Pencil,
+        Bucket,
+        Bucket8,
+        Rectangle,
+        Outline,
+        Select
+    };
+
     void onTileClicked(int row, int col);
+    void bucketFill(int row, int col);
+    void fillRect(const QRect& cells, bool outline);
+    QRect toolRect(const QPoint& from, const QPoint& to) const;
+
+    void setSelection(const QRect& cells);
+    void copySelection();
+    void cutSelection();
+    void startPaste();
+    void placeFloatingTiles(const QPoint& origin, const QRect& cleared);
+    void cancelFloatingTiles();
 
     void saveLevel();
     void newLevel();
     void deleteLevel();
     void importFromFile();
     void exportToFile();
+    void showTransferProgress(const QString& label);
+    void closeTransferProgress();
+    void transferFinished(const PackTransfer::Result& result);
     void helpDialog();
     void clearLevel();
     void resizeLevel(int newWidth, int newHeight);
-    void undoTilePlacement();
+    void undoEdit();
+    void redoEdit();
 
     QWidget* createActionButtons();
     void resizeDialog();
-    void parseLevel(const QString& levelString);
-    void loadLevelListFromFile(const QString& path) const;
-
-    struct TileAction {
-        int row;
-        int col;
-        QIcon previousIcon;
-        QVariant previousData;
-        bool isEmpty;
-    };
+    void parseLevel(int index);
+    void loadLevelListFromFile(const QString& path);
+    // Closing the pack waits for background jobs still reading it, so stop them first.
+    void cancelPackJobs();
+    int currentLevelIndex() const;
+    void selectLevel(int index);
+    // Asks what to do with unsaved edits; false if the user cancelled.
+    bool maybeSaveChanges();
+    void offerRecovery();
+    void updateAutosaveStatus();
+    void showWorldLevel(int number);
+    void showSearchMatch(int number, const QRect& cells);
+    // The selected tiles one row per line, as a search pattern.
+    QString selectionText() const;
+    void showChange(int index);
+    // Recolors the diff overlay for cells after an edit.
+    void updateDiffOverlay(const QRect& cells);
+    void hideDiffOverlay();
+    void showReachability(bool show);
+    void showReachSummary(const Reachability::Summary& summary);
+
+    static constexpr QSize toolIconSize{40, 40};
 
-    QStack<TileAction> undoStack;
+    EditHistory history;
+    AutoSaver autoSaver;
+    // Pack index of the level on the canvas, -1 for one that is not in the pack.
+    int editedIndex = -1;
+    WorldAnalyzer worldAnalyzer;
+    ReachAnalyzer reachAnalyzer;
+    PatternSearch patternSearch;
+    PackComparer packComparer;
+    PackTransfer packTransfer;
+    // Whether the running or last transfer is an import rather than an export.
+    bool importing = false;
+    std::shared_ptr<const PackComparer::Comparison> comparison;
+    // The other pack's version of the level on the canvas while its changes are shaded.
+    rle::Level diffBase;
+    QImage diffOverlay;
+    bool diffVisible = false;
+    bool reachVisible = false;
     TileType selectedTile;
+    Tool tool = Tool::Pencil;
     bool isDrawing = false;
+    QPoint lastCell;
+    QPoint toolAnchor;
+    QRect selection;
+    // Tiles following the mouse while pasting, or while the selection is dragged to a new place.
+    TileMap floatingTiles;
+    QPoint floatingGrab;
+    bool pasting = false;
+    bool movingSelection = false;
 
-    QTableWidget *level;
+    LevelCanvas *level;
     QToolBar *buttonLayout;
     TileIconManager tileIconManager;
-    QListWidget* levelListWidget;
+    QListView* levelListWidget;
+    LevelListModel* levelModel;
     DirectionInputWidget *dirWidget;
+    WorldPanel *worldPanel;
+    SearchPanel *searchPanel;
+    DiffPanel *diffPanel;
+    QLabel *reachLabel;
+    QLabel *autosaveLabel;
+    QProgressDialog *transferProgress = nullptr;
 };
 
 #endif // MAIN_WINDOW_H
@@ -0,0 +1,63 @@
+#include "PackComparer.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include "Trace.h"
+
+PackComparer::PackComparer()
+    : latest(std::make_shared<std::atomic<quint64>>(0))
+{
+    worker.setMaxThreadCount(1);
+}
+
+PackComparer::~PackComparer() {
+    latest->store(~quint64(0));
+    worker.clear();
+    worker.waitForDone();
+}
+
+void PackComparer::setResultHandler(QObject* context, ResultHandler handler) {
+    resultContext = context;
+    resultHandler = std::move(handler);
+}
+
+void PackComparer::start(const LevelPack& pack, const QString& otherPath) {
+    QElapsedTimer clock;
+    clock.start();
+    const quint64 job = ++generation;
+    latest->store(job);
+
+    worker.clear();
+    worker.start([this, latest = latest, snapshot = pack.snapshot(), otherPath, clock, job]() mutable {
+        TRACE_SCOPE("PackComparer::start");
+        auto comparison = std::make_shared<Comparison>();
+        comparison->path = otherPath;
+        QFile file(otherPath);
+        std::string error;
+        if (!file.open(QIODevice::ReadOnly)) comparison->error = file.errorString();
+        else {
+            const QByteArray content = file.readAll();
+            if (!packdiff::readPack(content.toStdString(), comparison->other, error))
+                comparison->error = QString::fromStdString(error);
+        }
+        if (comparison->error.isEmpty() && latest->load() == job) {
+            // Levels point into the mapped pack, or into scratch where they had to be re-encoded.
+            const int count = snapshot->count();
+            std::vector<std::string> scratch(static_cast<size_t>(count));
+            std::vector<packdiff::LevelText> current(static_cast<size_t>(count));
+            for (int i = 0; i < count; ++i) current[i] = {snapshot->number(i), snapshot->encoded(i, scratch[i])};
+            comparison->diff = packdiff::diffPacks(comparison->other.levels, current);
+        }
+        snapshot.reset();
+        comparison->milliseconds = clock.elapsed();
+        if (latest->load() != job || !resultContext) return;
+        QMetaObject::invokeMethod(resultContext.data(), [this, comparison = std::shared_ptr<const Comparison>(comparison), job] {
+            if (job == generation && resultHandler) resultHandler(comparison);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void PackComparer::cancel() {
+    latest->store(++generation);
+    worker.clear();
+}
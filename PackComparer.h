@@ -0,0 +1,50 @@
+#ifndef PACKCOMPARER_H
+#define PACKCOMPARER_H
+
+#include <QPointer>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "LevelPack.h"
+#include "PackDiff.h"
+
+// Diffs the open pack against another pack file off the GUI thread. The GUI thread
+// only takes a LevelPack::Snapshot of the open pack; both packs are read and
+// matched on a background thread, and only the latest comparison is
+// handed to the result handler.
+class PackComparer
+{
+public:
+    struct Comparison {
+        QString path;
+        // Empty when the other file was read; the diff is empty otherwise.
+        QString error;
+        // The other pack is the before side, so added levels are the ones only the open pack has.
+        packdiff::PackText other;
+        packdiff::PackDiff diff;
+        qint64 milliseconds = 0;
+    };
+
+    using ResultHandler = std::function<void(std::shared_ptr<const Comparison>)>;
+
+    PackComparer();
+    ~PackComparer();
+    PackComparer(const PackComparer&) = delete;
+    PackComparer& operator=(const PackComparer&) = delete;
+
+    // The handler runs on context's thread.
+    void setResultHandler(QObject* context, ResultHandler handler);
+    void start(const LevelPack& pack, const QString& otherPath);
+    void cancel();
+
+private:
+    quint64 generation = 0;
+    std::shared_ptr<std::atomic<quint64>> latest;
+    QThreadPool worker;
+    QPointer<QObject> resultContext;
+    ResultHandler resultHandler;
+};
+
+#endif // PACKCOMPARER_H
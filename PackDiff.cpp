@@ -0,0 +1,417 @@
+#include "PackDiff.h"
+#include "RlbFormat.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace packdiff {
+
+namespace {
+
+// Conflicting cells listed per level before the rest are summarized in one entry.
+constexpr size_t maxCellConflicts = 100;
+
+const char* const linkNames[4] = {"left", "right", "up", "down"};
+
+std::array<int, 4> linksOf(std::string_view links) {
+    rle::Level level;
+    rle::decode(links, level);
+    return {level.nextLevel[0], level.nextLevel[1], level.nextLevel[2], level.nextLevel[3]};
+}
+
+// Whether two rows with different text still hold the same tiles.
+bool sameTiles(std::string_view a, std::string_view b, rle::Level& scratchA, rle::Level& scratchB) {
+    if (rle::decode(a, scratchA) || rle::decode(b, scratchB)) return false;
+    return scratchA.tiles == scratchB.tiles;
+}
+
+int rowWidth(std::string_view row, rle::Level& scratch) {
+    return rle::decode(row, scratch) ? -1 : scratch.columns;
+}
+
+// Fills in the row-level part of a Modified diff; returns false if the levels hold
+// the same tiles and links after all.
+bool compareRows(std::string_view before, std::string_view after, LevelDiff& level) {
+    const EncodedRows a = splitRows(before);
+    const EncodedRows b = splitRows(after);
+    rle::Level scratchA;
+    rle::Level scratchB;
+    level.linksChanged = linksOf(a.links) != linksOf(b.links);
+    const int widthA = a.rows.empty() ? 0 : rowWidth(a.rows[0], scratchA);
+    const int widthB = b.rows.empty() ? 0 : rowWidth(b.rows[0], scratchB);
+    level.resized = a.rows.size() != b.rows.size() || widthA != widthB;
+    for (size_t r = 0; r < b.rows.size(); ++r) {
+        if (r < a.rows.size() && a.rows[r] == b.rows[r]) continue;
+        // Differently encoded runs of the same tiles are not a change.
+        if (!level.resized && sameTiles(a.rows[r], b.rows[r], scratchA, scratchB)) continue;
+        level.changedRows.push_back(static_cast<int>(r));
+    }
+    return level.resized || level.linksChanged || !level.changedRows.empty();
+}
+
+struct Grid {
+    int rows = 0;
+    int columns = 0;
+    int links[4] = {0, 0, 0, 0};
+    const char* tiles = nullptr;
+
+    bool contains(int r, int c) const { return r < rows && c < columns; }
+    // The tile at r, c, or -1 outside the grid.
+    int at(int r, int c) const {
+        return contains(r, c) ? static_cast<unsigned char>(tiles[static_cast<size_t>(r) * columns + c]) : -1;
+    }
+    bool sameSize(const Grid& other) const { return rows == other.rows && columns == other.columns; }
+};
+
+Grid gridOf(const rle::Level& level) {
+    Grid grid;
+    grid.rows = level.rows;
+    grid.columns = level.columns;
+    std::copy(level.nextLevel, level.nextLevel + 4, grid.links);
+    grid.tiles = level.tiles.data();
+    return grid;
+}
+
+class LevelMerger
+{
+public:
+    LevelMerger(int number, std::vector<Conflict>& conflicts)
+    : number(number), conflicts(conflicts) {}
+
+    // Merges three decoded versions; false if the level could only be taken from ours.
+    bool merge(const Grid& base, const Grid& ours, const Grid& theirs, std::string& out) {
+        Grid result;
+        const Grid* other = nullptr;
+        if (ours.sameSize(base)) {
+            result = theirs;
+            other = &ours;
+        }
+        else if (theirs.sameSize(base) || theirs.sameSize(ours)) {
+            result = ours;
+            other = &theirs;
+        }
+        else {
+            conflict(-1, -1, "resized differently on both sides");
+            return false;
+        }
+
+        std::vector<char> tiles(static_cast<size_t>(result.rows) * result.columns);
+        const bool sameSizes = base.sameSize(ours) && base.sameSize(theirs);
+        for (int r = 0; r < result.rows; ++r) {
+            char* row = tiles.data() + static_cast<size_t>(r) * result.columns;
+            if (sameSizes && copyWholeRow(base, ours, theirs, r, row)) continue;
+            for (int c = 0; c < result.columns; ++c) {
+                const int mine = ours.at(r, c);
+                const int yours = theirs.at(r, c);
+                const int original = base.at(r, c);
+                int tile = mine;
+                if (mine == yours || yours == original) tile = mine;
+                else if (mine == original) tile = yours;
+                else conflict(r, c, "cell changed on both sides");
+                row[c] = static_cast<char>(tile >= 0 ? tile : yours >= 0 ? yours : TileAir);
+            }
+        }
+        // Edits the chosen size cuts off are lost; say so.
+        for (int r = 0; r < other->rows; ++r) {
+            for (int c = 0; c < other->columns; ++c) {
+                if (!result.contains(r, c) && other->at(r, c) != base.at(r, c))
+                    conflict(r, c, "edited cell is outside the other side's new size");
+            }
+        }
+
+        int links[4];
+        for (int i = 0; i < 4; ++i) {
+            links[i] = ours.links[i];
+            if (ours.links[i] == theirs.links[i] || theirs.links[i] == base.links[i]) continue;
+            if (ours.links[i] == base.links[i]) links[i] = theirs.links[i];
+            else conflict(-1, -1, std::string(linkNames[i]) + " link changed on both sides");
+        }
+        finish();
+        rle::encode(tiles.data(), result.rows, result.columns, links, out);
+        return cellConflicts == 0 && !levelConflict;
+    }
+
+private:
+    static constexpr char TileAir = '-';
+
+    // The row as a whole when at most one side changed it.
+    static bool copyWholeRow(const Grid& base, const Grid& ours, const Grid& theirs, int r, char* row) {
+        const size_t width = static_cast<size_t>(base.columns);
+        const char* original = base.tiles + r * width;
+        const char* mine = ours.tiles + r * width;
+        const char* yours = theirs.tiles + r * width;
+        const char* source = nullptr;
+        if (std::memcmp(mine, yours, width) == 0 || std::memcmp(yours, original, width) == 0) source = mine;
+        else if (std::memcmp(mine, original, width) == 0) source = yours;
+        if (!source) return false;
+        std::memcpy(row, source, width);
+        return true;
+    }
+
+    void conflict(int row, int column, std::string reason) {
+        if (row < 0) levelConflict = true;
+        else if (cellConflicts++ >= maxCellConflicts) return;
+        conflicts.push_back({number, row, column, std::move(reason)});
+    }
+
+    void finish() {
+        if (cellConflicts > maxCellConflicts)
+            conflicts.push_back({number, -1, -1, std::to_string(cellConflicts - maxCellConflicts) + " more cells changed on both sides"});
+    }
+
+    int number;
+    std::vector<Conflict>& conflicts;
+    size_t cellConflicts = 0;
+    bool levelConflict = false;
+};
+
+} // namespace
+
+EncodedRows splitRows(std::string_view text) {
+    EncodedRows split;
+    const size_t links = text.find("::");
+    const std::string_view body = text.substr(0, links);
+    if (links != std::string_view::npos) split.links = text.substr(links);
+    size_t start = 0;
+    while (start < body.size()) {
+        size_t bar = body.find('|', start);
+        if (bar == std::string_view::npos) bar = body.size();
+        split.rows.push_back(body.substr(start, bar - start));
+        start = bar + 1;
+    }
+    return split;
+}
+
+bool readPack(std::string content, PackText& pack, std::string& error) {
+    pack = PackText();
+    pack.content = std::move(content);
+    if (rlb::isRlb(pack.content)) {
+        rlb::PackReader reader;
+        if (rle::Error failure = reader.open(pack.content)) {
+            error = rle::describe(failure);
+            return false;
+        }
+        pack.texts.resize(reader.count());
+        rle::Level level;
+        for (uint32_t i = 0; i < reader.count(); ++i) {
+            const int number = reader.entry(i).number;
+            if (rle::Error failure = reader.decode(i, level)) {
+                error = "Level " + std::to_string(number) + ": " + rle::describe(failure);
+                return false;
+            }
+            rle::encode(level, pack.texts[i]);
+            pack.levels.push_back({number, pack.texts[i]});
+        }
+        return true;
+    }
+    const std::vector<rle::PackRecord> records = rle::scanPack(pack.content);
+    // Reserved up front so the views into short strings survive the push_backs.
+    pack.texts.reserve(records.size());
+    std::string scratch;
+    for (const rle::PackRecord& record : records) {
+        std::string_view text = rle::recordText(std::string_view(pack.content).substr(record.offset, record.length), scratch);
+        // Levels written one row per line are joined in scratch and need a copy of their own.
+        if (text.data() == scratch.data()) text = pack.texts.emplace_back(text);
+        pack.levels.push_back({record.number, text});
+    }
+    return true;
+}
+
+const char* changeName(Change change) {
+    switch (change) {
+        case Change::Unchanged:  return "unchanged";
+        case Change::Modified:   return "modified";
+        case Change::Added:      return "added";
+        case Change::Removed:    return "removed";
+        case Change::Renumbered: return "renumbered";
+    }
+    return "unknown";
+}
+
+PackDiff diffPacks(const std::vector<LevelText>& before, const std::vector<LevelText>& after) {
+    const std::hash<std::string_view> hash;
+    std::unordered_multimap<size_t, int> byHash;
+    byHash.reserve(before.size());
+    for (size_t i = 0; i < before.size(); ++i) byHash.emplace(hash(before[i].text), static_cast<int>(i));
+
+    std::vector<bool> used(before.size(), false);
+    std::vector<LevelDiff> matched(after.size());
+    const auto pair = [&](size_t j, int i, Change change) {
+        used[static_cast<size_t>(i)] = true;
+        LevelDiff& level = matched[j];
+        level.change = change;
+        level.before = i;
+        level.after = static_cast<int>(j);
+        level.beforeNumber = before[static_cast<size_t>(i)].number;
+        level.afterNumber = after[j].number;
+    };
+
+    // Same text: unchanged when the number matches too, renumbered otherwise.
+    std::vector<size_t> hashes(after.size());
+    for (const bool sameNumber : {true, false}) {
+        for (size_t j = 0; j < after.size(); ++j) {
+            if (matched[j].after >= 0) continue;
+            if (sameNumber) hashes[j] = hash(after[j].text);
+            const auto [first, last] = byHash.equal_range(hashes[j]);
+            for (auto it = first; it != last; ++it) {
+                const LevelText& candidate = before[static_cast<size_t>(it->second)];
+                if (used[static_cast<size_t>(it->second)] || candidate.text != after[j].text) continue;
+                if (sameNumber && candidate.number != after[j].number) continue;
+                pair(j, it->second, sameNumber ? Change::Unchanged : Change::Renumbered);
+                break;
+            }
+        }
+    }
+
+    // Different text under the same number: compare the rows.
+    std::unordered_map<int, std::vector<int>> byNumber;
+    for (size_t i = 0; i < before.size(); ++i) {
+        if (!used[i]) byNumber[before[i].number].push_back(static_cast<int>(i));
+    }
+    for (size_t j = 0; j < after.size(); ++j) {
+        if (matched[j].after >= 0) continue;
+        const auto candidates = byNumber.find(after[j].number);
+        if (candidates == byNumber.end()) continue;
+        const auto free = std::find_if(candidates->second.begin(), candidates->second.end(),
+                                       [&](int i) { return !used[static_cast<size_t>(i)]; });
+        if (free == candidates->second.end()) continue;
+        pair(j, *free, Change::Modified);
+        if (!compareRows(before[static_cast<size_t>(*free)].text, after[j].text, matched[j]))
+            matched[j].change = Change::Unchanged;
+    }
+
+    PackDiff diff;
+    diff.levels.reserve(after.size());
+    for (size_t j = 0; j < after.size(); ++j) {
+        LevelDiff& level = matched[j];
+        if (level.after < 0) {
+            level.change = Change::Added;
+            level.after = static_cast<int>(j);
+            level.afterNumber = after[j].number;
+        }
+        diff.levels.push_back(std::move(level));
+    }
+    for (size_t i = 0; i < before.size(); ++i) {
+        if (used[i]) continue;
+        LevelDiff level;
+        level.change = Change::Removed;
+        level.before = static_cast<int>(i);
+        level.beforeNumber = before[i].number;
+        diff.levels.push_back(std::move(level));
+    }
+    for (const LevelDiff& level : diff.levels) {
+        switch (level.change) {
+            case Change::Unchanged:  ++diff.unchanged; break;
+            case Change::Modified:   ++diff.modified; break;
+            case Change::Added:      ++diff.added; break;
+            case Change::Removed:    ++diff.removed; break;
+            case Change::Renumbered: ++diff.renumbered; break;
+        }
+    }
+    return diff;
+}
+
+rle::Error diffCells(std::string_view before, std::string_view after, CellDiff& diff) {
+    const EncodedRows a = splitRows(before);
+    const EncodedRows b = splitRows(after);
+    diff = CellDiff();
+    rle::Level rowA;
+    rle::Level rowB;
+    for (size_t r = 0; r < b.rows.size(); ++r) {
+        const auto fail = [&](rle::Error error) {
+            error.row = static_cast<int>(r);
+            return error;
+        };
+        if (rle::Error error = rle::decode(b.rows[r], rowB)) return fail(error);
+        if (r == 0) {
+            diff.rows = static_cast<int>(b.rows.size());
+            diff.columns = rowB.columns;
+            diff.changed.assign(static_cast<size_t>(diff.rows) * diff.columns, 0);
+        }
+        if (rowB.columns != diff.columns) return fail({rle::ErrorCode::RaggedRow});
+        uint8_t* out = diff.changed.data() + r * diff.columns;
+        if (r >= a.rows.size()) {
+            std::fill_n(out, diff.columns, uint8_t(2));
+            diff.changedCells += static_cast<size_t>(diff.columns);
+            continue;
+        }
+        if (a.rows[r] == b.rows[r]) continue;
+        if (rle::Error error = rle::decode(a.rows[r], rowA)) return fail(error);
+        for (int c = 0; c < diff.columns; ++c) {
+            out[c] = c >= rowA.columns ? 2 : rowA.tiles[c] != rowB.tiles[c];
+            if (out[c]) ++diff.changedCells;
+        }
+    }
+    return {};
+}
+
+MergeResult mergePacks(const std::vector<LevelText>& base, const std::vector<LevelText>& ours,
+                       const std::vector<LevelText>& theirs) {
+    const auto index = [](const std::vector<LevelText>& pack) {
+        std::unordered_map<int, const LevelText*> byNumber;
+        for (const LevelText& level : pack) byNumber.emplace(level.number, &level);
+        return byNumber;
+    };
+    const auto baseLevels = index(base);
+    const auto ourLevels = index(ours);
+    const auto theirLevels = index(theirs);
+    const auto find = [](const std::unordered_map<int, const LevelText*>& levels, int number) -> const LevelText* {
+        const auto it = levels.find(number);
+        return it == levels.end() ? nullptr : it->second;
+    };
+    const auto same = [](const LevelText* a, const LevelText* b) {
+        return a == b || (a && b && a->text == b->text);
+    };
+
+    MergeResult result;
+    std::unordered_set<int> done;
+    const auto mergeNumber = [&](int number) {
+        const LevelText* original = find(baseLevels, number);
+        const LevelText* mine = find(ourLevels, number);
+        const LevelText* yours = find(theirLevels, number);
+        const auto take = [&](const LevelText* level) {
+            if (level) result.levels.push_back({number, std::string(level->text)});
+        };
+        if (same(mine, yours) || same(yours, original)) take(mine);
+        else if (same(mine, original)) take(yours);
+        else if (original && mine && yours) {
+            rle::Level decoded[3];
+            if (rle::decode(original->text, decoded[0]) || rle::decode(mine->text, decoded[1])
+                || rle::decode(yours->text, decoded[2])) {
+                result.conflicts.push_back({number, -1, -1, "a version of the level does not decode"});
+                take(mine);
+                return;
+            }
+            MergedLevel merged{number, {}};
+            LevelMerger merger(number, result.conflicts);
+            if (merger.merge(gridOf(decoded[0]), gridOf(decoded[1]), gridOf(decoded[2]), merged.text)) ++result.autoMerged;
+            if (merged.text.empty()) take(mine);
+            else result.levels.push_back(std::move(merged));
+        }
+        else {
+            const char* reason = !original ? "added differently on both sides"
+                               : !mine     ? "deleted in ours and changed in theirs"
+                                           : "changed in ours and deleted in theirs";
+            result.conflicts.push_back({number, -1, -1, reason});
+            take(mine ? mine : yours);
+        }
+    };
+
+    for (const LevelText& level : ours) {
+        if (done.insert(level.number).second) mergeNumber(level.number);
+        else {
+            result.conflicts.push_back({level.number, -1, -1, "duplicate level number in ours"});
+            result.levels.push_back({level.number, std::string(level.text)});
+        }
+    }
+    for (const LevelText& level : theirs) {
+        if (done.insert(level.number).second) mergeNumber(level.number);
+    }
+    return result;
+}
+
+} // namespace packdiff
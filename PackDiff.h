@@ -0,0 +1,127 @@
+#ifndef PACKDIFF_H
+#define PACKDIFF_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "RleCodec.h"
+
+// Structural diff and three-way merge of level packs, working on the encoded text
+// of each level (rle::recordText() of a .rll record, or the rle::encode() output
+// for one level).
+//
+// Levels are paired by a hash of their text first, so untouched and renumbered
+// levels cost one hash each; the rest are paired by level number. Paired levels
+// are compared row by row on the encoded rows, which never needs a decode, and
+// only rows whose text differs are decoded and compared tile by tile.
+namespace packdiff {
+
+struct LevelText {
+    int number = 0;
+    std::string_view text;
+};
+
+// The rows of an encoded level and its "::" link suffix, split without decoding.
+struct EncodedRows {
+    std::vector<std::string_view> rows;
+    std::string_view links;
+};
+
+EncodedRows splitRows(std::string_view text);
+
+// Every level of a .rll or .rlb pack file as text; .rlb levels are re-encoded so
+// both formats compare alike. levels point into content and texts, so a PackText
+// is filled where it will stay rather than copied.
+struct PackText {
+    std::string content;
+    std::vector<std::string> texts;
+    std::vector<LevelText> levels;
+};
+
+// Takes the file content; false with a message in error if it is not a readable pack.
+bool readPack(std::string content, PackText& pack, std::string& error);
+
+enum class Change {
+    Unchanged,
+    Modified,
+    Added,
+    Removed,
+    Renumbered
+};
+
+const char* changeName(Change change);
+
+struct LevelDiff {
+    Change change = Change::Unchanged;
+    // Positions in the before and after lists, -1 for the side a level is missing from.
+    int before = -1;
+    int after = -1;
+    int beforeNumber = 0;
+    int afterNumber = 0;
+    // Modified levels only: rows of the after level whose text differs, and whether
+    // the size or the next level links changed.
+    std::vector<int> changedRows;
+    bool resized = false;
+    bool linksChanged = false;
+};
+
+struct PackDiff {
+    // Every level of after in order, then the levels removed from before.
+    std::vector<LevelDiff> levels;
+    size_t unchanged = 0;
+    size_t modified = 0;
+    size_t added = 0;
+    size_t removed = 0;
+    size_t renumbered = 0;
+
+    bool isEmpty() const { return modified + added + removed + renumbered == 0; }
+};
+
+PackDiff diffPacks(const std::vector<LevelText>& before, const std::vector<LevelText>& after);
+
+// Cell-level comparison of two versions of a level. changed gets one byte per cell
+// of after: 0 for cells equal to before, 1 for changed cells and 2 for cells outside
+// the bounds of before.
+struct CellDiff {
+    int rows = 0;
+    int columns = 0;
+    std::vector<uint8_t> changed;
+    size_t changedCells = 0;
+};
+
+rle::Error diffCells(std::string_view before, std::string_view after, CellDiff& diff);
+
+struct Conflict {
+    int number = 0;
+    // The cell both sides changed differently; -1, -1 for a conflict about the whole
+    // level (added, removed or resized differently) or its links.
+    int row = -1;
+    int column = -1;
+    std::string reason;
+};
+
+struct MergedLevel {
+    int number = 0;
+    std::string text;
+};
+
+struct MergeResult {
+    std::vector<MergedLevel> levels;
+    std::vector<Conflict> conflicts;
+    // Levels both sides changed whose edits were combined without conflict.
+    size_t autoMerged = 0;
+};
+
+// Combines the changes ours and theirs made to base, matched by level number.
+// Edits to different levels, rows or cells are combined; where both sides changed
+// the same thing differently, ours wins (or the side that kept a level the other
+// deleted) and the spot is listed as a conflict. The result keeps the order of
+// ours, followed by the levels only theirs added.
+MergeResult mergePacks(const std::vector<LevelText>& base, const std::vector<LevelText>& ours,
+                       const std::vector<LevelText>& theirs);
+
+} // namespace packdiff
+
+#endif // PACKDIFF_H
@@ -0,0 +1,158 @@
+#include "PackStream.h"
+
+#include <algorithm>
+#include <charconv>
+
+namespace rle {
+
+namespace {
+
+constexpr std::string_view levelHeader = "; Level";
+// Table entries read per seek into the .rlb level table.
+constexpr uint32_t tableChunk = 4096;
+
+std::string_view trimmed(std::string_view text) {
+    const auto space = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; };
+    while (!text.empty() && space(text.front())) text.remove_prefix(1);
+    while (!text.empty() && space(text.back())) text.remove_suffix(1);
+    return text;
+}
+
+bool parseHeader(std::string_view line, int& number) {
+    line = trimmed(line);
+    if (line.substr(0, levelHeader.size()) != levelHeader) return false;
+    line = trimmed(line.substr(levelHeader.size()));
+    number = 0;
+    std::from_chars(line.data(), line.data() + line.size(), number);
+    return true;
+}
+
+} // namespace
+
+bool PackStream::open(const std::string& path, std::string& error) {
+    *this = PackStream();
+    file.open(path, std::ios::binary);
+    if (!file) {
+        error = "unable to open " + path;
+        return false;
+    }
+    file.seekg(0, std::ios::end);
+    fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+
+    char bytes[rlb::headerSize] = {};
+    file.read(bytes, sizeof(bytes));
+    const std::string_view start(bytes, static_cast<size_t>(file.gcount()));
+    isBinary = rlb::isRlb(start);
+    if (isBinary) {
+        if (Error failure = rlb::readHeader(start, fileSize, header)) {
+            error = describe(failure);
+            return false;
+        }
+        if (!(header.flags & rlb::flagSharedRows)) return true;
+        const uint64_t rowsAt = header.tableOffset + static_cast<uint64_t>(header.levelCount) * rlb::tableEntrySize;
+        sharedRows.resize(static_cast<size_t>(fileSize - rowsAt));
+        file.seekg(static_cast<std::streamoff>(rowsAt));
+        if (!file.read(sharedRows.data(), static_cast<std::streamsize>(sharedRows.size()))) {
+            error = "read error in the shared rows";
+            return false;
+        }
+        if (Error failure = dictionary.open(sharedRows)) {
+            failure.offset += rowsAt;
+            error = describe(failure);
+            return false;
+        }
+        return true;
+    }
+    file.clear();
+    file.seekg(0);
+    return true;
+}
+
+uint64_t PackStream::position() const {
+    if (!isBinary) return std::min(bytesRead, fileSize);
+    return header.levelCount == 0 ? fileSize : fileSize * index / header.levelCount;
+}
+
+bool PackStream::next(Record& record) {
+    if (!readError.empty() || !file.is_open()) return false;
+    return isBinary ? nextBinary(record) : nextText(record);
+}
+
+bool PackStream::fail(std::string message) {
+    readError = std::move(message);
+    return false;
+}
+
+bool PackStream::nextText(Record& record) {
+    // Anything before the first header is not part of a level.
+    while (!haveHeader && std::getline(file, lineBuffer)) {
+        ++lineNumber;
+        bytesRead += lineBuffer.size() + 1;
+        haveHeader = parseHeader(lineBuffer, headerNumber);
+    }
+    if (!haveHeader) return file.bad() ? fail("read error") : false;
+
+    record = Record();
+    record.number = headerNumber;
+    record.line = lineNumber + 1;
+    record.offset = bytesRead;
+    raw.clear();
+    haveHeader = false;
+    while (std::getline(file, lineBuffer)) {
+        ++lineNumber;
+        bytesRead += lineBuffer.size() + 1;
+        if (parseHeader(lineBuffer, headerNumber)) {
+            haveHeader = true;
+            break;
+        }
+        raw += lineBuffer;
+        raw += '\n';
+    }
+    if (file.bad()) return fail("read error");
+    record.raw = raw;
+    record.text = recordText(raw, text);
+    return true;
+}
+
+bool PackStream::nextBinary(Record& record) {
+    if (index >= header.levelCount) return false;
+    if (table.empty() || index >= tableFirst + tableChunk) {
+        tableFirst = index;
+        const uint32_t entries = std::min(tableChunk, header.levelCount - index);
+        table.resize(static_cast<size_t>(entries) * rlb::tableEntrySize);
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(header.tableOffset + static_cast<uint64_t>(index) * rlb::tableEntrySize));
+        if (!file.read(table.data(), static_cast<std::streamsize>(table.size()))) return fail("read error in the level table");
+    }
+    const rlb::TableEntry entry = rlb::readTableEntry(table.data() + static_cast<size_t>(index - tableFirst) * rlb::tableEntrySize);
+    ++index;
+
+    record = Record();
+    record.number = entry.number;
+    record.offset = entry.offset;
+    if (entry.offset > fileSize || entry.length > fileSize - entry.offset) {
+        record.error = {ErrorCode::Truncated, static_cast<size_t>(std::min(entry.offset, fileSize)), 0, 0};
+        return true;
+    }
+    raw.resize(entry.length);
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(entry.offset));
+    if (!file.read(raw.data(), static_cast<std::streamsize>(raw.size()))) return fail("read error");
+    record.raw = raw;
+    const rlb::RowDictionary* rows = header.flags & rlb::flagSharedRows ? &dictionary : nullptr;
+    if ((record.error = rlb::decodeLevel(raw, level, rows))) return true;
+    encode(level, text);
+    record.text = text;
+    return true;
+}
+
+void PackStream::locate(const Record& record, size_t textOffset, uint64_t& line, uint64_t& column) {
+    const size_t at = std::min(recordOffset(record.raw, textOffset), record.raw.size());
+    const std::string_view before = record.raw.substr(0, at);
+    const size_t lineStart = before.rfind('\n');
+    line = record.line + static_cast<uint64_t>(std::count(before.begin(), before.end(), '\n'));
+    column = lineStart == std::string_view::npos ? at + 1 : at - lineStart;
+}
+
+} // namespace rle
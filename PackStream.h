@@ -0,0 +1,81 @@
+#ifndef PACKSTREAM_H
+#define PACKSTREAM_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "RleCodec.h"
+#include "RlbFormat.h"
+
+namespace rle {
+
+// Reads the levels of a .rll or .rlb pack file one at a time, for packs too big to
+// map or read whole: only the current level and a slice of the .rlb level table
+// are held in memory, plus the shared rows of a .rlb pack that has them. Text packs
+// are read line by line with the same record rules as scanPack(); binary packs seek
+// from the table to each record.
+class PackStream
+{
+public:
+    struct Record {
+        int number = 0;
+        // The encoded level as recordText() gives it; .rlb records are re-encoded as text.
+        std::string_view text;
+        // Text packs: the lines after the "; Level" header, their first line (1-based)
+        // and file offset. Binary packs: the file offset of the record, line 0.
+        std::string_view raw;
+        uint64_t line = 0;
+        uint64_t offset = 0;
+        // Set when a .rlb record does not decode; text is empty then.
+        Error error;
+    };
+
+    bool open(const std::string& path, std::string& error);
+    bool binary() const { return isBinary; }
+    // A .rlb pack with flagSharedRows.
+    bool hasSharedRows() const { return isBinary && (header.flags & rlb::flagSharedRows); }
+    uint64_t size() const { return fileSize; }
+    // Bytes of the file behind the records read so far.
+    uint64_t position() const;
+    // False at the end of the pack, or with error() set when the file cannot be read.
+    bool next(Record& record);
+    const std::string& error() const { return readError; }
+
+    // Line and column, both 1-based, of an offset into the text of a record from a
+    // text pack.
+    static void locate(const Record& record, size_t textOffset, uint64_t& line, uint64_t& column);
+
+private:
+    bool nextText(Record& record);
+    bool nextBinary(Record& record);
+    bool fail(std::string message);
+
+    std::ifstream file;
+    uint64_t fileSize = 0;
+    bool isBinary = false;
+    std::string readError;
+    std::string raw;
+    std::string text;
+
+    // Text packs.
+    std::string lineBuffer;
+    uint64_t lineNumber = 0;
+    uint64_t bytesRead = 0;
+    bool haveHeader = false;
+    int headerNumber = 0;
+
+    // Binary packs.
+    rlb::Header header;
+    uint32_t index = 0;
+    std::vector<char> table;
+    uint32_t tableFirst = 0;
+    std::string sharedRows;
+    rlb::RowDictionary dictionary;
+    Level level;
+};
+
+} // namespace rle
+
+#endif // PACKSTREAM_H
@@ -0,0 +1,304 @@
+#include "PackTransfer.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSaveFile>
+#include <unordered_map>
+#include <unordered_set>
+#include "LevelPack.h"
+#include "PackStream.h"
+#include "RlbFormat.h"
+#include "Trace.h"
+
+namespace {
+
+// Output is handed to the file in blocks of about this size.
+constexpr size_t writeBlockBytes = size_t(1) << 20;
+
+bool writeBlock(QFileDevice& output, std::string& block, QString& error) {
+    if (output.write(block.data(), static_cast<qint64>(block.size())) != static_cast<qint64>(block.size())) {
+        error = output.errorString();
+        return false;
+    }
+    block.clear();
+    return true;
+}
+
+} // namespace
+
+struct PackTransfer::Job {
+    quint64 id = 0;
+    std::shared_ptr<std::atomic<quint64>> latest;
+    std::function<void(int)> report;
+    Result result;
+    // Bytes to stream through in total and in the phases already finished.
+    quint64 total = 0;
+    quint64 done = 0;
+    int percent = -1;
+
+    bool cancelled() const { return latest->load() != id; }
+
+    void progress(quint64 position) {
+        const int now = total == 0 ? 100 : static_cast<int>((done + position) * 100 / total);
+        if (now == percent) return;
+        percent = now;
+        report(now);
+    }
+
+    // Records a level that does not decode; offset is into the record's text.
+    void badRecord(const rle::PackStream::Record& record, const rle::Error& error) {
+        if (result.badRecordCount++ >= static_cast<int>(maxListedBadRecords)) return;
+        BadRecord bad;
+        bad.number = record.number;
+        if (record.line > 0) rle::PackStream::locate(record, error.offset, bad.line, bad.column);
+        else bad.column = record.offset + error.offset;
+        bad.message = rle::describe(error.code);
+        result.badRecords.push_back(bad);
+    }
+};
+
+PackTransfer::PackTransfer()
+    : latest(std::make_shared<std::atomic<quint64>>(0))
+{
+    worker.setMaxThreadCount(1);
+}
+
+PackTransfer::~PackTransfer() {
+    latest->store(~quint64(0));
+    worker.clear();
+    worker.waitForDone();
+}
+
+void PackTransfer::setHandlers(QObject* context, ProgressHandler progress, FinishedHandler finished) {
+    resultContext = context;
+    progressHandler = std::move(progress);
+    finishedHandler = std::move(finished);
+}
+
+void PackTransfer::start(std::function<void(Job&)> work, std::function<void()> settle) {
+    const quint64 id = ++generation;
+    latest->store(id);
+
+    worker.clear();
+    worker.start([this, latest = latest, work = std::move(work), settle = std::move(settle), id] {
+        QElapsedTimer clock;
+        clock.start();
+        const auto post = [this, id](auto&& call) {
+            if (!resultContext) return;
+            QMetaObject::invokeMethod(resultContext.data(), [this, call = std::move(call), id] {
+                if (id == generation) call();
+            }, Qt::QueuedConnection);
+        };
+        if (settle) settle();
+        Job job;
+        job.id = id;
+        job.latest = latest;
+        job.report = [&post, this](int percent) {
+            post([this, percent] {
+                if (progressHandler) progressHandler(percent);
+            });
+        };
+        work(job);
+        if (job.cancelled()) return;
+        job.result.milliseconds = clock.elapsed();
+        post([this, result = std::move(job.result)] {
+            if (finishedHandler) finishedHandler(result);
+        });
+    });
+}
+
+void PackTransfer::startImport(const QString& packPath, const QString& sourcePath, const QString& mergedPath,
+                               std::function<void()> settle) {
+    start([packPath, sourcePath, mergedPath](Job& job) {
+        TRACE_SCOPE("PackTransfer::import");
+        Result& result = job.result;
+        // Left behind by an import that did not finish.
+        QFile::remove(mergedPath);
+        rle::PackStream pack;
+        rle::PackStream source;
+        std::string error;
+        const bool hasPack = QFile::exists(packPath);
+        if ((hasPack && !pack.open(QFile::encodeName(packPath).toStdString(), error))
+            || !source.open(QFile::encodeName(sourcePath).toStdString(), error)) {
+            result.error = QString::fromStdString(error);
+            return;
+        }
+        QFile output(mergedPath);
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            result.error = output.errorString();
+            return;
+        }
+        const auto abandon = [&](QString message) {
+            result.error = std::move(message);
+            output.remove();
+        };
+        job.total = (hasPack ? pack.size() : 0) + 2 * source.size();
+        result.path = mergedPath;
+
+        // The merged pack replaces the open one, so it is written in the same format.
+        const bool binary = hasPack ? pack.binary() : LevelPack::isBinaryPath(packPath);
+        rlb::PackWriter packWriter(hasPack && pack.hasSharedRows());
+
+        // Levels of the merged pack by their canonical encoding, and the numbers in use.
+        std::unordered_map<std::string, int> known;
+        std::unordered_set<int> numbers;
+        int maxNumber = 0;
+        rle::Level level;
+        std::string canonical;
+        std::string block;
+        if (binary) block.append(rlb::headerSize, '\0');
+        rle::PackStream::Record record;
+
+        while (hasPack && pack.next(record)) {
+            if (job.cancelled()) return abandon({});
+            job.progress(pack.position());
+            const rle::Error decodeError = record.error ? record.error : rle::decode(record.text, level);
+            // A text pack keeps a level that does not decode as it is, a .rlb pack cannot.
+            if ((record.error || binary) && decodeError)
+                return abandon(QString("Level %1 of the open pack does not decode").arg(record.number));
+            if (!decodeError) {
+                rle::encode(level, canonical);
+                known.emplace(canonical, record.number);
+            }
+            numbers.insert(record.number);
+            maxNumber = std::max(maxNumber, record.number);
+            if (binary) packWriter.add(record.number, level, block);
+            else rle::appendPackRecord(record.number, record.text, block);
+            if (block.size() >= writeBlockBytes && !writeBlock(output, block, result.error)) return abandon(result.error);
+        }
+        if (!pack.error().empty()) return abandon(QString::fromStdString(pack.error()));
+        job.done += pack.size();
+
+        // First pass: validate, drop duplicates and choose the numbers of the new levels.
+        std::vector<int> targets;
+        std::unordered_map<int, int> renumbering;
+        while (source.next(record)) {
+            if (job.cancelled()) return abandon({});
+            job.progress(source.position());
+            targets.push_back(0);
+            if (record.error) {
+                job.badRecord(record, record.error);
+                continue;
+            }
+            if (rle::Error decodeError = rle::decode(record.text, level)) {
+                job.badRecord(record, decodeError);
+                continue;
+            }
+            rle::encode(level, canonical);
+            const auto [existing, added] = known.try_emplace(canonical, 0);
+            if (!added) {
+                ++result.duplicates;
+                renumbering.emplace(record.number, existing->second);
+                continue;
+            }
+            int number = record.number;
+            if (number <= 0 || !numbers.insert(number).second) {
+                number = ++maxNumber;
+                numbers.insert(number);
+                ++result.renumbered;
+            }
+            maxNumber = std::max(maxNumber, number);
+            existing->second = number;
+            renumbering.emplace(record.number, number);
+            targets.back() = number;
+        }
+        if (!source.error().empty()) return abandon(QString::fromStdString(source.error()));
+        job.done += source.size();
+
+        // Second pass: append the new levels with their links following the renumbering.
+        if (!source.open(QFile::encodeName(sourcePath).toStdString(), error)) return abandon(QString::fromStdString(error));
+        for (size_t index = 0; source.next(record); ++index) {
+            if (job.cancelled()) return abandon({});
+            job.progress(source.position());
+            if (index >= targets.size()) return abandon("The imported file changed while it was read");
+            if (targets[index] == 0 || rle::decode(record.text, level)) continue;
+            for (int& link : level.nextLevel) {
+                const auto target = renumbering.find(link);
+                if (link > 0 && target != renumbering.end()) link = target->second;
+            }
+            if (binary) packWriter.add(targets[index], level, block);
+            else {
+                rle::encode(level, canonical);
+                rle::appendPackRecord(targets[index], canonical, block);
+            }
+            ++result.levels;
+            if (block.size() >= writeBlockBytes && !writeBlock(output, block, result.error)) return abandon(result.error);
+        }
+        if (!source.error().empty()) return abandon(QString::fromStdString(source.error()));
+        char header[rlb::headerSize];
+        if (binary) packWriter.finish(block, header);
+        if (!writeBlock(output, block, result.error)) return abandon(result.error);
+        if (binary && (!output.seek(0) || output.write(header, sizeof(header)) != sizeof(header)))
+            return abandon(output.errorString());
+        if (!output.flush()) return abandon(output.errorString());
+        job.progress(source.size());
+    }, std::move(settle));
+}
+
+void PackTransfer::startExport(const QString& packPath, const QString& destination, bool sharedRows,
+                               std::function<void()> settle) {
+    start([packPath, destination, sharedRows](Job& job) {
+        TRACE_SCOPE("PackTransfer::export");
+        Result& result = job.result;
+        rle::PackStream pack;
+        std::string error;
+        if (!pack.open(QFile::encodeName(packPath).toStdString(), error)) {
+            result.error = QString::fromStdString(error);
+            return;
+        }
+        QSaveFile output(destination);
+        if (!output.open(QIODevice::WriteOnly)) {
+            result.error = output.errorString();
+            return;
+        }
+        job.total = pack.size();
+        result.path = destination;
+
+        const bool binary = LevelPack::isBinaryPath(destination);
+        rlb::PackWriter packWriter(binary && sharedRows);
+        std::string block;
+        if (binary) block.append(rlb::headerSize, '\0');
+        rle::Level level;
+        rle::PackStream::Record record;
+        while (pack.next(record)) {
+            if (job.cancelled()) return;
+            job.progress(pack.position());
+            rle::Error decodeError = record.error;
+            if (!decodeError) decodeError = rle::decode(record.text, level);
+            if (decodeError) {
+                job.badRecord(record, decodeError);
+                continue;
+            }
+            // Nothing is kept once a level is bad, but the rest are still checked so all get reported.
+            if (result.badRecordCount > 0) continue;
+            if (binary) packWriter.add(record.number, level, block);
+            else rle::appendPackRecord(record.number, record.text, block);
+            ++result.levels;
+            if (block.size() >= writeBlockBytes && !writeBlock(output, block, result.error)) return;
+        }
+        if (!pack.error().empty()) {
+            result.error = QString::fromStdString(pack.error());
+            return;
+        }
+        if (result.badRecordCount > 0) {
+            result.error = QString("%1 levels do not decode").arg(result.badRecordCount);
+            return;
+        }
+        if (binary) {
+            char bytes[rlb::headerSize];
+            packWriter.finish(block, bytes);
+            if (!writeBlock(output, block, result.error)) return;
+            if (!output.seek(0) || output.write(bytes, sizeof(bytes)) != sizeof(bytes)) {
+                result.error = output.errorString();
+                return;
+            }
+        }
+        else if (!writeBlock(output, block, result.error)) return;
+        if (!output.commit()) result.error = output.errorString();
+    }, std::move(settle));
+}
+
+void PackTransfer::cancel() {
+    latest->store(++generation);
+    worker.clear();
+}
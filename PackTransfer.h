@@ -0,0 +1,84 @@
+#ifndef PACKTRANSFER_H
+#define PACKTRANSFER_H
+
+#include <QPointer>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Imports and exports level packs on a background thread. Both read their input
+// with rle::PackStream, so only one level at a time is decoded whatever the size
+// of the file.
+//
+// An import copies the open pack into a new file of the same format, keeping the
+// shared rows of a .rlb pack that has them, and appends the levels of the imported
+// pack that it does not already contain, matched by their canonical encoding, which
+// it keeps in memory for every distinct level. Imported levels keep their numbers
+// where they are free and are renumbered past the highest number otherwise, with
+// the next level links between them following along. Records that do not decode
+// are skipped and reported with their line and column.
+class PackTransfer
+{
+public:
+    struct BadRecord {
+        int number = 0;
+        // 1-based line and column in a text pack; 0 and the byte offset of the record in a binary one.
+        quint64 line = 0;
+        quint64 column = 0;
+        QString message;
+    };
+
+    struct Result {
+        // The file written: the export destination, or the merged pack of an import.
+        QString path;
+        // Empty on success; nothing was written otherwise.
+        QString error;
+        int levels = 0;
+        // Imports only: levels already in the pack or repeated in the file, and levels
+        // given a new number.
+        int duplicates = 0;
+        int renumbered = 0;
+        // The first maxListedBadRecords records that did not decode, out of badRecordCount.
+        std::vector<BadRecord> badRecords;
+        int badRecordCount = 0;
+        qint64 milliseconds = 0;
+    };
+
+    static constexpr size_t maxListedBadRecords = 100;
+
+    using ProgressHandler = std::function<void(int percent)>;
+    using FinishedHandler = std::function<void(const Result&)>;
+
+    PackTransfer();
+    ~PackTransfer();
+    PackTransfer(const PackTransfer&) = delete;
+    PackTransfer& operator=(const PackTransfer&) = delete;
+
+    // Both handlers run on context's thread, and only for the latest job.
+    void setHandlers(QObject* context, ProgressHandler progress, FinishedHandler finished);
+    // settle runs first on the background thread and returns once packPath holds
+    // every saved level, e.g. by waiting for LevelPack's compaction.
+    void startImport(const QString& packPath, const QString& sourcePath, const QString& mergedPath,
+                     std::function<void()> settle);
+    // Writes .rlb when destination ends in .rlb, with shared rows if sharedRows, and .rll otherwise.
+    void startExport(const QString& packPath, const QString& destination, bool sharedRows,
+                     std::function<void()> settle);
+    void cancel();
+
+private:
+    struct Job;
+
+    void start(std::function<void(Job&)> work, std::function<void()> settle);
+
+    quint64 generation = 0;
+    std::shared_ptr<std::atomic<quint64>> latest;
+    QThreadPool worker;
+    QPointer<QObject> resultContext;
+    ProgressHandler progressHandler;
+    FinishedHandler finishedHandler;
+};
+
+#endif // PACKTRANSFER_H
@@ -0,0 +1,109 @@
+#include "PatternMatcher.h"
+
+#include <algorithm>
+
+bool PatternMatcher::setPattern(std::vector<std::string> rows, std::string& error) {
+    if (rows.empty() || rows[0].empty()) {
+        error = "The pattern is empty.";
+        return false;
+    }
+    const size_t rowWidth = rows[0].size();
+    if (std::any_of(rows.begin(), rows.end(), [&](const std::string& row) { return row.size() != rowWidth; })) {
+        error = "Every pattern row must have the same length.";
+        return false;
+    }
+    if (rows.size() > maxSize || rowWidth > maxSize) {
+        error = "Patterns can be at most " + std::to_string(maxSize) + " tiles wide and tall.";
+        return false;
+    }
+
+    patternRows = std::move(rows);
+    width = static_cast<int>(rowWidth);
+    rowsPerWord = 64 / width;
+
+    std::vector<std::string> distinct;
+    distinctRowMask.clear();
+    for (size_t i = 0; i < patternRows.size(); ++i) {
+        const auto d = static_cast<size_t>(std::find(distinct.begin(), distinct.end(), patternRows[i]) - distinct.begin());
+        if (d == distinct.size()) {
+            distinct.push_back(patternRows[i]);
+            distinctRowMask.push_back(0);
+        }
+        distinctRowMask[d] |= uint64_t(1) << i;
+    }
+
+    // Distinct row d occupies bits [s * width, (s + 1) * width) of word d / rowsPerWord,
+    // s = d % rowsPerWord. A bit carried out of one row lands on the next row's start
+    // bit, which is set on every step anyway.
+    words.assign((distinct.size() + rowsPerWord - 1) / rowsPerWord, Word());
+    for (size_t d = 0; d < distinct.size(); ++d) {
+        Word& word = words[d / rowsPerWord];
+        const int first = static_cast<int>(d % rowsPerWord) * width;
+        word.start |= uint64_t(1) << first;
+        word.end |= uint64_t(1) << (first + width - 1);
+        for (int j = 0; j < width; ++j) {
+            const uint64_t bit = uint64_t(1) << (first + j);
+            const char tile = distinct[d][j];
+            if (tile == wildcard) {
+                for (uint64_t& accepts : word.accepts) accepts |= bit;
+            }
+            else word.accepts[static_cast<unsigned char>(tile)] |= bit;
+        }
+    }
+    rowState.assign(words.size(), 0);
+    error.clear();
+    return true;
+}
+
+bool PatternMatcher::setPattern(const std::string& text, std::string& error) {
+    std::vector<std::string> rows;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos) end = text.size();
+        std::string row = text.substr(start, end - start);
+        while (!row.empty() && (row.back() == ' ' || row.back() == '\t' || row.back() == '\r')) row.pop_back();
+        rows.push_back(std::move(row));
+        start = end + 1;
+    }
+    while (!rows.empty() && rows.back().empty()) rows.pop_back();
+    while (!rows.empty() && rows.front().empty()) rows.erase(rows.begin());
+    return setPattern(std::move(rows), error);
+}
+
+size_t PatternMatcher::find(const char* tiles, int rows, int columns, std::vector<Match>& matches, size_t limit) {
+    const int height = this->rows();
+    if (height == 0 || rows < height || columns < width) return 0;
+    const uint64_t complete = uint64_t(1) << (height - 1);
+    const size_t wordCount = words.size();
+    size_t found = 0;
+    columnState.assign(static_cast<size_t>(columns), 0);
+
+    for (int r = 0; r < rows; ++r) {
+        const auto* row = reinterpret_cast<const unsigned char*>(tiles) + static_cast<size_t>(r) * columns;
+        std::fill(rowState.begin(), rowState.end(), 0);
+        for (int c = 0; c < columns; ++c) {
+            // Pattern rows that match the width cells ending at c.
+            uint64_t matched = 0;
+            for (size_t w = 0; w < wordCount; ++w) {
+                const Word& word = words[w];
+                uint64_t& state = rowState[w];
+                state = (state << 1 | word.start) & word.accepts[row[c]];
+                uint64_t ends = state & word.end;
+                if (!ends) continue;
+                ends >>= width - 1;
+                for (size_t d = w * rowsPerWord; ends; ++d) {
+                    if (ends & 1) matched |= distinctRowMask[d];
+                    ends = width < 64 ? ends >> width : 0;
+                }
+            }
+            // Bit i: pattern rows 0..i match the rows ending at r in this column.
+            uint64_t& column = columnState[static_cast<size_t>(c)];
+            column = matched ? (column << 1 | 1) & matched : 0;
+            if (column & complete) {
+                if (found++ < limit) matches.push_back({r - height + 1, c - width + 1});
+            }
+        }
+    }
+    return found;
+}
@@ -0,0 +1,61 @@
+#ifndef PATTERNMATCHER_H
+#define PATTERNMATCHER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Finds every placement of a rectangular tile pattern in a level; '?' in the
+// pattern matches any tile.
+//
+// Each level row runs through a bit-parallel Shift-And automaton that follows all
+// distinct pattern rows at once, packed side by side into 64-bit words. A second
+// Shift-And per column then chains the row matches it reports into matches of the
+// whole pattern, so a level is scanned in a single pass over its cells.
+class PatternMatcher
+{
+public:
+    static constexpr char wildcard = '?';
+    static constexpr int maxSize = 64;
+
+    struct Match {
+        int row;
+        int column;
+    };
+
+    // Rows must be non-empty and of equal length, at most maxSize wide and tall.
+    bool setPattern(std::vector<std::string> rows, std::string& error);
+    // One pattern row per line; trailing spaces and blank lines are ignored.
+    bool setPattern(const std::string& text, std::string& error);
+
+    const std::vector<std::string>& pattern() const { return patternRows; }
+    int rows() const { return static_cast<int>(patternRows.size()); }
+    int columns() const { return width; }
+    bool isEmpty() const { return patternRows.empty(); }
+
+    // Counts every occurrence and appends the top-left cells of the first limit of
+    // them in row-major order. Keeps scratch state, so threads need their own copy.
+    size_t find(const char* tiles, int rows, int columns, std::vector<Match>& matches,
+                size_t limit = std::numeric_limits<size_t>::max());
+
+private:
+    struct Word {
+        uint64_t start = 0;
+        uint64_t end = 0;
+        std::array<uint64_t, 256> accepts{};
+    };
+
+    std::vector<std::string> patternRows;
+    int width = 0;
+    int rowsPerWord = 0;
+    std::vector<Word> words;
+    // For each distinct row, the pattern rows equal to it as a mask.
+    std::vector<uint64_t> distinctRowMask;
+    std::vector<uint64_t> rowState;
+    std::vector<uint64_t> columnState;
+};
+
+#endif // PATTERNMATCHER_H
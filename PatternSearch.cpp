@@ -0,0 +1,95 @@
+#include "PatternSearch.h"
+
+#include <QElapsedTimer>
+#include "Trace.h"
+#include "WorkStealingPool.h"
+
+namespace {
+
+constexpr int levelsPerTask = 32;
+
+} // namespace
+
+PatternSearch::PatternSearch()
+    : latest(std::make_shared<std::atomic<quint64>>(0))
+{
+    worker.setMaxThreadCount(1);
+}
+
+PatternSearch::~PatternSearch() {
+    latest->store(~quint64(0));
+    worker.clear();
+    worker.waitForDone();
+}
+
+void PatternSearch::setHandlers(QObject* context, ResultHandler results, FinishedHandler finished) {
+    resultContext = context;
+    resultHandler = std::move(results);
+    finishedHandler = std::move(finished);
+}
+
+void PatternSearch::start(const LevelPack& pack, const PatternMatcher& matcher) {
+    QElapsedTimer clock;
+    clock.start();
+    const quint64 job = ++generation;
+    latest->store(job);
+
+    worker.clear();
+    worker.start([this, latest = latest, snapshot = pack.snapshot(), matcher, clock, job]() mutable {
+        TRACE_SCOPE("PatternSearch::start");
+        const int count = snapshot->count();
+        std::atomic<int> failed{0};
+        std::atomic<size_t> total{0};
+        const auto post = [this, job](auto&& call) {
+            if (!resultContext) return;
+            QMetaObject::invokeMethod(resultContext.data(), [this, call = std::move(call), job] {
+                if (job == generation) call();
+            }, Qt::QueuedConnection);
+        };
+        {
+            WorkStealingPool pool;
+            for (int first = 0; first < count; first += levelsPerTask) {
+                pool.submit([&, first] {
+                    if (latest->load() != job) return;
+                    PatternMatcher scanner = matcher;
+                    rle::Level level;
+                    std::vector<LevelMatches> found;
+                    const int last = std::min(count, first + levelsPerTask);
+                    for (int i = first; i < last && latest->load() == job; ++i) {
+                        if (snapshot->read(i, level)) {
+                            ++failed;
+                            continue;
+                        }
+                        LevelMatches result;
+                        result.index = i;
+                        result.number = snapshot->number(i);
+                        result.count = scanner.find(level.tiles.data(), level.rows, level.columns, result.matches,
+                                                    maxListedMatches);
+                        if (result.count == 0) continue;
+                        total += result.count;
+                        found.push_back(std::move(result));
+                    }
+                    if (found.empty() || latest->load() != job) return;
+                    post([this, found = std::move(found)] {
+                        if (resultHandler) resultHandler(found);
+                    });
+                });
+            }
+        }
+        snapshot.reset();
+        if (latest->load() != job) return;
+        Summary summary;
+        summary.levels = count;
+        summary.failedLevels = failed;
+        summary.matches = total;
+        summary.milliseconds = clock.elapsed();
+        post([this, summary] {
+            if (finishedHandler) finishedHandler(summary);
+        });
+    });
+}
+
+void PatternSearch::cancel() {
+    latest->store(++generation);
+    worker.clear();
+}
@@ -0,0 +1,60 @@
+#ifndef PATTERNSEARCH_H
+#define PATTERNSEARCH_H
+
+#include <QPointer>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "LevelPack.h"
+#include "PatternMatcher.h"
+
+// Runs a PatternMatcher over every level of a pack off the GUI thread. The GUI
+// thread only takes a LevelPack::Snapshot; reading, decoding and matching run in
+// parallel on a work-stealing pool, and each range of levels hands its matches to the result
+// handler as soon as it is done. Starting a new search or cancel() stops the
+// running one between levels.
+class PatternSearch
+{
+public:
+    // Matches beyond this many per level are counted but not listed.
+    static constexpr size_t maxListedMatches = 200;
+
+    struct LevelMatches {
+        int index = 0;
+        int number = 0;
+        size_t count = 0;
+        std::vector<PatternMatcher::Match> matches;
+    };
+
+    struct Summary {
+        int levels = 0;
+        int failedLevels = 0;
+        size_t matches = 0;
+        qint64 milliseconds = 0;
+    };
+
+    using ResultHandler = std::function<void(const std::vector<LevelMatches>&)>;
+    using FinishedHandler = std::function<void(const Summary&)>;
+
+    PatternSearch();
+    ~PatternSearch();
+    PatternSearch(const PatternSearch&) = delete;
+    PatternSearch& operator=(const PatternSearch&) = delete;
+
+    // Both handlers run on context's thread, and only for the latest search.
+    void setHandlers(QObject* context, ResultHandler results, FinishedHandler finished);
+    void start(const LevelPack& pack, const PatternMatcher& matcher);
+    void cancel();
+
+private:
+    quint64 generation = 0;
+    std::shared_ptr<std::atomic<quint64>> latest;
+    QThreadPool worker;
+    QPointer<QObject> resultContext;
+    ResultHandler resultHandler;
+    FinishedHandler finishedHandler;
+};
+
+#endif // PATTERNSEARCH_H
@@ -0,0 +1,84 @@
+#include "ReachAnalyzer.h"
+
+#include <QtAlgorithms>
+#include "Trace.h"
+
+namespace {
+
+// Later classes are painted over earlier ones.
+QImage overlayImage(const Reachability& engine) {
+    const BitGrid& reach = engine.reachable();
+    QImage image(reach.columns(), reach.rows(), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    const std::pair<const BitGrid*, QRgb> layers[] = {
+        {&engine.reachable(), qPremultiply(qRgba(0, 200, 80, 70))},
+        {&engine.exits(), qPremultiply(qRgba(40, 120, 255, 190))},
+        {&engine.reachableCoins(), qPremultiply(qRgba(255, 200, 0, 200))},
+        {&engine.hazards(), qPremultiply(qRgba(230, 0, 0, 170))},
+    };
+    for (int r = 0; r < reach.rows(); ++r) {
+        auto* pixels = reinterpret_cast<QRgb*>(image.scanLine(r));
+        for (const auto& [grid, color] : layers) {
+            const uint64_t* bits = grid->row(r);
+            for (int w = 0; w < grid->wordsPerRow(); ++w) {
+                for (uint64_t word = bits[w]; word; word &= word - 1)
+                    pixels[w * 64 + qCountTrailingZeroBits(word)] = color;
+            }
+        }
+    }
+    return image;
+}
+
+} // namespace
+
+ReachAnalyzer::ReachAnalyzer()
+    : engine(std::make_shared<Reachability>()), latest(std::make_shared<std::atomic<quint64>>(0))
+{
+    worker.setMaxThreadCount(1);
+}
+
+ReachAnalyzer::~ReachAnalyzer() {
+    latest->store(~quint64(0));
+    worker.clear();
+    worker.waitForDone();
+}
+
+void ReachAnalyzer::setResultHandler(QObject* context, ResultHandler handler) {
+    resultContext = context;
+    resultHandler = std::move(handler);
+}
+
+void ReachAnalyzer::setTiles(const TileMap& map) {
+    // Queued updates would only be overwritten by this snapshot.
+    worker.clear();
+    start([map](Reachability& reachability) { reachability.setTiles(map); });
+}
+
+void ReachAnalyzer::tilesChanged(const TileMap& map, const QRect& cells) {
+    const QRect area = cells & QRect(0, 0, map.columns(), map.rows());
+    if (area.isEmpty()) return;
+    start([map, area](Reachability& reachability) {
+        reachability.updateTiles(map, area.top(), area.left(), area.bottom(), area.right());
+    });
+}
+
+void ReachAnalyzer::cancel() {
+    latest->store(++generation);
+}
+
+void ReachAnalyzer::start(std::function<void(Reachability&)> apply) {
+    const quint64 job = ++generation;
+    latest->store(job);
+    worker.start([this, engine = engine, latest = latest, apply = std::move(apply), job] {
+        apply(*engine);
+        if (latest->load() != job) return;
+        TRACE_SCOPE("ReachAnalyzer::solve");
+        engine->solve();
+        QImage overlay = overlayImage(*engine);
+        const Reachability::Summary summary = engine->summary();
+        if (latest->load() != job || !resultContext || !resultHandler) return;
+        QMetaObject::invokeMethod(resultContext.data(), [this, overlay = std::move(overlay), summary, job] {
+            if (job == generation) resultHandler(overlay, summary);
+        }, Qt::QueuedConnection);
+    });
+}
@@ -0,0 +1,46 @@
+#ifndef REACHANALYZER_H
+#define REACHANALYZER_H
+
+#include <QImage>
+#include <QPointer>
+#include <QRect>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "Reachability.h"
+
+// Runs Reachability for the level on the canvas on a background thread. Every edit
+// sends a copy-on-write snapshot of the tiles with the changed cells and is applied
+// in order; a job that already has a newer one queued behind it skips the search. Results come back as an overlay
+// image with one pixel per cell.
+class ReachAnalyzer
+{
+public:
+    using ResultHandler = std::function<void(const QImage&, const Reachability::Summary&)>;
+
+    ReachAnalyzer();
+    ~ReachAnalyzer();
+    ReachAnalyzer(const ReachAnalyzer&) = delete;
+    ReachAnalyzer& operator=(const ReachAnalyzer&) = delete;
+
+    // The handler runs on context's thread with the newest result.
+    void setResultHandler(QObject* context, ResultHandler handler);
+    void setTiles(const TileMap& map);
+    void tilesChanged(const TileMap& map, const QRect& cells);
+    // Drops results of jobs still in flight.
+    void cancel();
+
+private:
+    void start(std::function<void(Reachability&)> apply);
+
+    // Only touched by jobs on worker, which runs one job at a time.
+    std::shared_ptr<Reachability> engine;
+    quint64 generation = 0;
+    std::shared_ptr<std::atomic<quint64>> latest;
+    QThreadPool worker;
+    QPointer<QObject> resultContext;
+    ResultHandler resultHandler;
+};
+
+#endif // REACHANALYZER_H
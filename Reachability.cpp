@@ -0,0 +1,291 @@
+#include "Reachability.h"
+
+#include <cstring>
+
+namespace {
+
+// dst = src and both horizontal neighbours of every bit in src.
+void spread(const uint64_t* src, uint64_t* dst, int words) {
+    for (int w = 0; w < words; ++w) {
+        uint64_t bits = src[w] | src[w] << 1 | src[w] >> 1;
+        if (w > 0) bits |= src[w - 1] >> 63;
+        if (w + 1 < words) bits |= src[w + 1] << 63;
+        dst[w] = bits;
+    }
+}
+
+bool any(const uint64_t* bits, int words) {
+    for (int w = 0; w < words; ++w) {
+        if (bits[w]) return true;
+    }
+    return false;
+}
+
+bool isOneOf(char tile, const char* set) {
+    return tile != '\0' && std::strchr(set, tile) != nullptr;
+}
+
+} // namespace
+
+Reachability::Reachability()
+    : Reachability(Rules())
+{
+}
+
+Reachability::Reachability(Rules rules)
+    : rules(rules)
+{
+    this->rules.jumpHeight = std::max(this->rules.jumpHeight, 1);
+    this->rules.springHeight = std::max(this->rules.springHeight, 1);
+    layers = std::max(this->rules.jumpHeight, this->rules.springHeight);
+}
+
+void Reachability::setTiles(TileMap tiles) {
+    map = std::move(tiles);
+    const int rows = map.rows();
+    const int columns = map.columns();
+    for (BitGrid* grid : {&open, &enterable, &support, &spring, &deadly, &coin, &exitTile, &spawn,
+                          &reach, &coinsReached, &hazardsTouched, &exitCells})
+        *grid = BitGrid(rows, columns);
+    visited.assign(layers, BitGrid(rows, columns));
+    frontier.assign(layers, BitGrid(rows, columns));
+    next.assign(layers, BitGrid(rows, columns));
+    frontierRows.assign(layers, {});
+    nextRows.assign(layers, {});
+    scratch.assign(static_cast<size_t>(open.wordsPerRow()) * 3, 0);
+    rowTiles.resize(static_cast<size_t>(columns));
+    classifyRows(0, rows - 1);
+    needsFullSolve = true;
+    dirty.clear();
+}
+
+void Reachability::updateTiles(TileMap tiles, int top, int left, int bottom, int right) {
+    map = std::move(tiles);
+    top = std::max(top, 0);
+    left = std::max(left, 0);
+    bottom = std::min(bottom, map.rows() - 1);
+    right = std::min(right, map.columns() - 1);
+    if (top > bottom || left > right) return;
+    classifyRows(top, bottom);
+    if (!needsFullSolve) dirty.push_back({top, left, bottom, right});
+}
+
+void Reachability::classifyRows(int first, int last) {
+    for (int r = first; r <= last; ++r) {
+        for (BitGrid* grid : {&open, &enterable, &support, &spring, &deadly, &coin, &exitTile, &spawn})
+            std::fill_n(grid->row(r), grid->wordsPerRow(), 0);
+        map.readRow(r, 0, map.columns(), rowTiles.data());
+        for (int c = 0; c < map.columns(); ++c) {
+            const char tile = rowTiles[c];
+            if (!isOneOf(tile, "#S^&")) open.set(r, c);
+            if (!isOneOf(tile, "#S^&P")) enterable.set(r, c);
+            if (isOneOf(tile, "#PS")) support.set(r, c);
+            if (tile == 'S') spring.set(r, c);
+            if (isOneOf(tile, "^&")) deadly.set(r, c);
+            if (tile == '*') coin.set(r, c);
+            if (tile == 'E') exitTile.set(r, c);
+            if (isOneOf(tile, "LRUD")) spawn.set(r, c);
+        }
+    }
+}
+
+void Reachability::solve() {
+    if (needsFullSolve) {
+        solveFull();
+        return;
+    }
+    if (dirty.empty()) return;
+    for (const Dirty& area : dirty) {
+        if (nearReach(area)) {
+            solveFull();
+            return;
+        }
+    }
+    // Nothing reachable borders the patches, so the search never looked at them; only
+    // spawn tiles they added can extend the result.
+    const int words = open.wordsPerRow();
+    uint64_t* fresh = scratch.data();
+    for (const Dirty& area : dirty) {
+        for (int r = area.top; r <= area.bottom; ++r) {
+            for (int w = 0; w < words; ++w) fresh[w] = spawn.row(r)[w] & ~reach.row(r)[w];
+            if (any(fresh, words)) seed(r, fresh);
+        }
+    }
+    dirty.clear();
+    propagate();
+    collect();
+}
+
+void Reachability::solveFull() {
+    for (int layer = 0; layer < layers; ++layer) {
+        visited[layer].clear();
+        frontier[layer].clear();
+        next[layer].clear();
+        frontierRows[layer].clear();
+        nextRows[layer].clear();
+    }
+    reach.clear();
+    hazardsTouched.clear();
+    exitCells.clear();
+    edgeExits = 0;
+    for (int r = 0; r < map.rows(); ++r) {
+        if (spawn.rowAny(r)) seed(r, spawn.row(r));
+    }
+    needsFullSolve = false;
+    dirty.clear();
+    propagate();
+    collect();
+}
+
+void Reachability::seed(int row, const uint64_t* bits) {
+    push(0, row, bits, open);
+}
+
+void Reachability::push(int layer, int row, const uint64_t* bits, const BitGrid& allowed) {
+    const int words = allowed.wordsPerRow();
+    uint64_t* hit = hazardsTouched.row(row);
+    const uint64_t* danger = deadly.row(row);
+    const uint64_t* mask = allowed.row(row);
+    uint64_t* seen = visited[layer].row(row);
+    uint64_t* queued = next[layer].row(row);
+    uint64_t* all = reach.row(row);
+    bool wasQueued = false;
+    bool checked = false;
+    for (int w = 0; w < words; ++w) {
+        hit[w] |= bits[w] & danger[w];
+        const uint64_t added = bits[w] & mask[w] & ~seen[w];
+        if (!added) continue;
+        if (!checked) {
+            wasQueued = any(queued, words);
+            checked = true;
+        }
+        seen[w] |= added;
+        queued[w] |= added;
+        all[w] |= added;
+    }
+    if (checked && !wasQueued) nextRows[layer].push_back(row);
+}
+
+void Reachability::propagate() {
+    const int rows = map.rows();
+    const int words = open.wordsPerRow();
+    uint64_t* grounded = scratch.data();
+    uint64_t* airborne = grounded + words;
+    uint64_t* moved = airborne + words;
+    const int jumpLayer = rules.jumpHeight - 1;
+    const int springLayer = rules.springHeight - 1;
+
+    const auto leaveTop = [&](const uint64_t* bits) {
+        if (!any(bits, words)) return;
+        edgeExits |= ExitUp;
+        for (int w = 0; w < words; ++w) exitCells.row(0)[w] |= bits[w];
+    };
+    const auto rise = [&](int layer, int r, const uint64_t* bits) {
+        if (r == 0) {
+            leaveTop(bits);
+            return;
+        }
+        spread(bits, moved, words);
+        push(layer, r - 1, moved, open);
+    };
+
+    for (;;) {
+        frontier.swap(next);
+        frontierRows.swap(nextRows);
+        bool active = false;
+        for (int layer = 0; layer < layers; ++layer) {
+            for (const int r : frontierRows[layer]) {
+                active = true;
+                uint64_t* cells = frontier[layer].row(r);
+                if (layer > 0) {
+                    rise(layer - 1, r, cells);
+                    push(0, r, cells, open);
+                }
+                else {
+                    const bool bottom = r + 1 == rows;
+                    const uint64_t* below = bottom ? nullptr : support.row(r + 1);
+                    for (int w = 0; w < words; ++w) {
+                        grounded[w] = below ? cells[w] & below[w] : 0;
+                        airborne[w] = cells[w] & ~grounded[w];
+                    }
+                    if (any(grounded, words)) {
+                        for (int w = 0; w < words; ++w) {
+                            moved[w] = grounded[w] << 1 | grounded[w] >> 1;
+                            if (w > 0) moved[w] |= grounded[w - 1] >> 63;
+                            if (w + 1 < words) moved[w] |= grounded[w + 1] << 63;
+                        }
+                        push(0, r, moved, open);
+                        rise(jumpLayer, r, grounded);
+                        const uint64_t* springs = spring.row(r + 1);
+                        for (int w = 0; w < words; ++w) grounded[w] &= springs[w];
+                        if (any(grounded, words)) rise(springLayer, r, grounded);
+                    }
+                    if (any(airborne, words)) {
+                        if (bottom) {
+                            edgeExits |= ExitDown;
+                            for (int w = 0; w < words; ++w) exitCells.row(r)[w] |= airborne[w];
+                        }
+                        else {
+                            spread(airborne, moved, words);
+                            push(0, r + 1, moved, enterable);
+                        }
+                    }
+                }
+                std::fill_n(cells, words, 0);
+            }
+            frontierRows[layer].clear();
+        }
+        if (!active) break;
+    }
+}
+
+bool Reachability::nearReach(const Dirty& area) const {
+    const int top = std::max(area.top - 1, 0);
+    const int bottom = std::min(area.bottom + 1, map.rows() - 1);
+    const int left = std::max(area.left - 1, 0);
+    const int right = std::min(area.right + 1, map.columns() - 1);
+    for (int r = top; r <= bottom; ++r) {
+        const uint64_t* bits = reach.row(r);
+        for (int w = left / 64; w <= right / 64; ++w) {
+            uint64_t mask = ~uint64_t(0);
+            if (w == left / 64) mask &= ~uint64_t(0) << (left % 64);
+            if (w == right / 64 && right % 64 != 63) mask &= (uint64_t(1) << (right % 64 + 1)) - 1;
+            if (bits[w] & mask) return true;
+        }
+    }
+    return false;
+}
+
+void Reachability::collect() {
+    const int words = reach.wordsPerRow();
+    const int last = map.columns() - 1;
+    unsigned exits = edgeExits;
+    for (int r = 0; r < map.rows(); ++r) {
+        const uint64_t* reached = reach.row(r);
+        uint64_t* coins = coinsReached.row(r);
+        uint64_t* leaving = exitCells.row(r);
+        const uint64_t* coinTiles = coin.row(r);
+        const uint64_t* exitTiles = exitTile.row(r);
+        for (int w = 0; w < words; ++w) {
+            coins[w] = reached[w] & coinTiles[w];
+            const uint64_t tiles = reached[w] & exitTiles[w];
+            if (tiles) exits |= ExitTile;
+            leaving[w] |= tiles;
+        }
+        if (last < 0) continue;
+        if (reach.test(r, 0)) {
+            exits |= ExitLeft;
+            exitCells.set(r, 0);
+        }
+        if (reach.test(r, last)) {
+            exits |= ExitRight;
+            exitCells.set(r, last);
+        }
+    }
+    totals.reachableCells = reach.count();
+    totals.coins = coin.count();
+    totals.reachableCoins = coinsReached.count();
+    totals.hazards = hazardsTouched.count();
+    totals.spawns = spawn.count();
+    totals.exits = exits;
+}
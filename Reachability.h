@@ -0,0 +1,108 @@
+#ifndef REACHABILITY_H
+#define REACHABILITY_H
+
+#include <cstddef>
+#include <vector>
+#include "BitGrid.h"
+#include "TileMap.h"
+
+// Which cells of a level the player can get to from its spawn tiles, under an
+// approximation of the game's movement: '#' and 'S' are solid, 'P' can be jumped
+// through from below and stood on, standing on 'S' launches the player upward,
+// and touching '^' or '&' kills. Jumps and falls may drift one column per row.
+//
+// The search is a breadth-first flood over packed bit rows, one set of rows per
+// remaining jump height. After updateTiles(), solve() only reruns the search when
+// the edit borders a reachable cell; otherwise the old result still holds and
+// is at most extended from spawn tiles added by the edit.
+class Reachability
+{
+public:
+    struct Rules {
+        int jumpHeight = 3;
+        int springHeight = 7;
+    };
+
+    // Bits of Summary::exits; the edges are in next_level order.
+    enum Exit : unsigned {
+        ExitLeft = 1,
+        ExitRight = 2,
+        ExitUp = 4,
+        ExitDown = 8,
+        ExitTile = 16
+    };
+
+    struct Summary {
+        size_t reachableCells = 0;
+        size_t coins = 0;
+        size_t reachableCoins = 0;
+        size_t hazards = 0;
+        size_t spawns = 0;
+        unsigned exits = 0;
+    };
+
+    Reachability();
+    explicit Reachability(Rules rules);
+
+    const TileMap& tiles() const { return map; }
+    void setTiles(TileMap tiles);
+    // Replaces the tiles with a copy of the same size that differs only in the given cells.
+    void updateTiles(TileMap tiles, int top, int left, int bottom, int right);
+    // Brings the results below up to date with the tiles.
+    void solve();
+
+    const BitGrid& reachable() const { return reach; }
+    const BitGrid& reachableCoins() const { return coinsReached; }
+    // Deadly cells the player can run into.
+    const BitGrid& hazards() const { return hazardsTouched; }
+    // Reachable cells the player can leave the level from.
+    const BitGrid& exits() const { return exitCells; }
+    Summary summary() const { return totals; }
+
+private:
+    struct Dirty {
+        int top, left, bottom, right;
+    };
+
+    void classifyRows(int first, int last);
+    void solveFull();
+    void seed(int row, const uint64_t* bits);
+    void propagate();
+    void push(int layer, int row, const uint64_t* bits, const BitGrid& allowed);
+    bool nearReach(const Dirty& area) const;
+    void collect();
+
+    Rules rules;
+    int layers;
+    TileMap map;
+    bool needsFullSolve = true;
+    std::vector<Dirty> dirty;
+
+    // Per-cell tile classes.
+    BitGrid open;
+    BitGrid enterable;
+    BitGrid support;
+    BitGrid spring;
+    BitGrid deadly;
+    BitGrid coin;
+    BitGrid exitTile;
+    BitGrid spawn;
+
+    // Search state: one grid per remaining jump height, 0 meaning walking or falling.
+    std::vector<BitGrid> visited;
+    std::vector<BitGrid> frontier;
+    std::vector<BitGrid> next;
+    std::vector<std::vector<int>> frontierRows;
+    std::vector<std::vector<int>> nextRows;
+    std::vector<uint64_t> scratch;
+    std::vector<char> rowTiles;
+    unsigned edgeExits = 0;
+
+    BitGrid reach;
+    BitGrid coinsReached;
+    BitGrid hazardsTouched;
+    BitGrid exitCells;
+    Summary totals;
+};
+
+#endif // REACHABILITY_H
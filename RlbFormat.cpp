@@ -0,0 +1,411 @@
+#include "RlbFormat.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace rlb {
+
+namespace {
+
+void put16(char* out, uint16_t value) {
+    out[0] = static_cast<char>(value);
+    out[1] = static_cast<char>(value >> 8);
+}
+
+void put32(char* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out[i] = static_cast<char>(value >> (8 * i));
+}
+
+void put64(char* out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) out[i] = static_cast<char>(value >> (8 * i));
+}
+
+uint16_t get16(const char* in) {
+    return static_cast<uint16_t>(static_cast<unsigned char>(in[0]) | static_cast<unsigned char>(in[1]) << 8);
+}
+
+uint32_t get32(const char* in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) value |= static_cast<uint32_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    return value;
+}
+
+uint64_t get64(const char* in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) value |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    return value;
+}
+
+void putVarint(std::string& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+rle::Error truncated(size_t offset, int row = 0, int column = 0) {
+    return {rle::ErrorCode::Truncated, offset, row, column};
+}
+
+void putRun(std::string& out, char tile, uint32_t count) {
+    const auto byte = static_cast<unsigned char>(tile);
+    if (count == 1 && byte < 0x80) {
+        out.push_back(tile);
+        return;
+    }
+    if (byte < 0x7F) out.push_back(static_cast<char>(byte | 0x80));
+    else {
+        out.push_back(static_cast<char>(0xFF));
+        out.push_back(tile);
+    }
+    putVarint(out, count);
+}
+
+void encodeRow(const char* row, int columns, std::string& out) {
+    const char* end = row + columns;
+    while (row != end) {
+        const char tile = *row;
+        const char* run = row + 1;
+        while (run != end && *run == tile) ++run;
+        putRun(out, tile, static_cast<uint32_t>(run - row));
+        row = run;
+    }
+}
+
+// Multiply and xor-shift over 8-byte words; encoded rows are short, so this is
+// cheaper than the byte-at-a-time std::hash.
+uint64_t hashRow(std::string_view row) {
+    uint64_t hash = 0x9E3779B97F4A7C15ull ^ row.size();
+    size_t i = 0;
+    for (; i + 8 <= row.size(); i += 8) {
+        uint64_t word;
+        std::memcpy(&word, row.data() + i, 8);
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 32;
+    }
+    uint64_t tail = 0;
+    if (i < row.size()) std::memcpy(&tail, row.data() + i, row.size() - i);
+    hash = (hash ^ tail) * 0xC4CEB9FE1A85EC53ull;
+    return hash ^ (hash >> 29);
+}
+
+// Row data for one row; position is an offset into record.
+rle::Error decodeRow(std::string_view record, size_t position, size_t end, int row, int columns, char* out) {
+    int column = 0;
+    while (position < end) {
+        const auto lead = static_cast<unsigned char>(record[position++]);
+        char tile = static_cast<char>(lead);
+        uint32_t count = 1;
+        if (lead >= 0x80) {
+            tile = static_cast<char>(lead & 0x7F);
+            if (lead == 0xFF) {
+                if (position >= end) return truncated(position, row, column);
+                tile = record[position++];
+            }
+            count = 0;
+            for (int shift = 0;; shift += 7) {
+                if (position >= end || shift > 28) return truncated(position, row, column);
+                const auto byte = static_cast<unsigned char>(record[position++]);
+                count |= static_cast<uint32_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) break;
+            }
+        }
+        if (count > static_cast<uint32_t>(columns - column)) return {rle::ErrorCode::RaggedRow, position, row, column};
+        std::memset(out + column, tile, count);
+        column += static_cast<int>(count);
+    }
+    if (column != columns) return {rle::ErrorCode::RaggedRow, position, row, column};
+    return {};
+}
+
+} // namespace
+
+bool isRlb(std::string_view file) {
+    return file.size() >= sizeof(magic) && std::memcmp(file.data(), magic, sizeof(magic)) == 0;
+}
+
+void writeHeader(const Header& header, char out[headerSize]) {
+    std::memcpy(out, magic, sizeof(magic));
+    put16(out + 4, header.version);
+    put16(out + 6, header.flags);
+    put32(out + 8, header.levelCount);
+    put64(out + 12, header.tableOffset);
+    put32(out + 20, 0);
+}
+
+void writeTableEntry(const TableEntry& entry, char out[tableEntrySize]) {
+    put64(out, entry.offset);
+    put32(out + 8, entry.length);
+    put32(out + 12, static_cast<uint32_t>(entry.number));
+}
+
+void encodeLevel(const char* tiles, int rows, int columns, const int nextLevel[4], std::string& out) {
+    rows = columns > 0 ? rows : 0;
+    const size_t offsetsAt = out.size() + recordHeaderSize;
+    const size_t dataAt = offsetsAt + 4 * (static_cast<size_t>(rows) + 1);
+    out.resize(dataAt);
+    char* header = out.data() + offsetsAt - recordHeaderSize;
+    put32(header, static_cast<uint32_t>(rows));
+    put32(header + 4, static_cast<uint32_t>(columns));
+    for (int i = 0; i < 4; ++i) put32(header + 8 + 4 * i, static_cast<uint32_t>(nextLevel[i]));
+
+    for (int i = 0; i < rows; ++i) {
+        put32(out.data() + offsetsAt + 4 * i, static_cast<uint32_t>(out.size() - dataAt));
+        encodeRow(tiles + static_cast<size_t>(i) * columns, columns, out);
+    }
+    put32(out.data() + offsetsAt + 4 * rows, static_cast<uint32_t>(out.size() - dataAt));
+}
+
+rle::Error readLevelInfo(std::string_view record, LevelInfo& info, const RowDictionary* dictionary) {
+    if (record.size() < recordHeaderSize) return truncated(record.size());
+    const uint32_t rows = get32(record.data());
+    const uint32_t columns = get32(record.data() + 4);
+    // A zero side lets the other one through the tile limit, and it has to fit in an int.
+    if (rows > INT_MAX || columns > INT_MAX || static_cast<uint64_t>(rows) * columns > rle::maxLevelTiles)
+        return {rle::ErrorCode::LevelTooLarge, 0, 0, 0};
+    const size_t rowTable = 4 * (static_cast<size_t>(rows) + (dictionary ? 0 : 1));
+    if (record.size() < recordHeaderSize + rowTable) return truncated(record.size());
+    info.rows = static_cast<int>(rows);
+    info.columns = static_cast<int>(columns);
+    for (int i = 0; i < 4; ++i) info.nextLevel[i] = static_cast<int32_t>(get32(record.data() + 8 + 4 * i));
+    return {};
+}
+
+rle::Error decodeRows(std::string_view record, int firstRow, int rowCount, rle::Level& level,
+                      const RowDictionary* dictionary) {
+    LevelInfo info;
+    if (rle::Error error = readLevelInfo(record, info, dictionary)) return error;
+    if (firstRow < 0 || rowCount < 0 || firstRow + rowCount > info.rows) return {rle::ErrorCode::Truncated, 0, firstRow, 0};
+
+    const size_t offsetsAt = recordHeaderSize;
+    const size_t dataAt = offsetsAt + 4 * (static_cast<size_t>(info.rows) + 1);
+    level.rows = rowCount;
+    level.columns = info.columns;
+    for (int i = 0; i < 4; ++i) level.nextLevel[i] = info.nextLevel[i];
+    level.tiles.resize(static_cast<size_t>(rowCount) * info.columns);
+    for (int i = 0; i < rowCount; ++i) {
+        const int row = firstRow + i;
+        char* out = level.tiles.data() + static_cast<size_t>(i) * info.columns;
+        if (dictionary) {
+            // Errors point at the row id, the shared row has no place in the record.
+            const size_t at = offsetsAt + 4 * static_cast<size_t>(row);
+            std::string_view bytes;
+            if (!dictionary->row(get32(record.data() + at), bytes)) return {rle::ErrorCode::BadFormat, at, row, 0};
+            if (rle::Error error = decodeRow(bytes, 0, bytes.size(), row, info.columns, out)) {
+                error.offset = at;
+                return error;
+            }
+            continue;
+        }
+        const size_t begin = dataAt + get32(record.data() + offsetsAt + 4 * row);
+        const size_t end = dataAt + get32(record.data() + offsetsAt + 4 * (row + 1));
+        if (begin > end || end > record.size()) return truncated(record.size(), row);
+        if (rle::Error error = decodeRow(record, begin, end, row, info.columns, out)) return error;
+    }
+    return {};
+}
+
+rle::Error decodeLevel(std::string_view record, rle::Level& level, const RowDictionary* dictionary) {
+    LevelInfo info;
+    if (rle::Error error = readLevelInfo(record, info, dictionary)) return error;
+    return decodeRows(record, 0, info.rows, level, dictionary);
+}
+
+rle::Error readHeader(std::string_view bytes, uint64_t fileSize, Header& header) {
+    header = Header();
+    if (bytes.size() < headerSize || !isRlb(bytes)) return {rle::ErrorCode::BadFormat, 0, 0, 0};
+    header.version = get16(bytes.data() + 4);
+    header.flags = get16(bytes.data() + 6);
+    header.levelCount = get32(bytes.data() + 8);
+    header.tableOffset = get64(bytes.data() + 12);
+    if (header.version != formatVersion) return {rle::ErrorCode::BadFormat, 4, 0, 0};
+    if (header.tableOffset > fileSize || (fileSize - header.tableOffset) / tableEntrySize < header.levelCount) {
+        header.levelCount = 0;
+        return truncated(fileSize);
+    }
+    return {};
+}
+
+TableEntry readTableEntry(const char in[tableEntrySize]) {
+    return {get64(in), get32(in + 8), static_cast<int32_t>(get32(in + 12))};
+}
+
+rle::Error RowDictionary::open(std::string_view bytes) {
+    *this = RowDictionary();
+    if (bytes.size() < 4) return truncated(bytes.size());
+    const uint32_t count = get32(bytes.data());
+    const uint64_t offsetsSize = 8 * (static_cast<uint64_t>(count) + 1);
+    if (bytes.size() - 4 < offsetsSize) return truncated(bytes.size());
+    const uint64_t dataSize = get64(bytes.data() + 4 + 8 * static_cast<size_t>(count));
+    if (bytes.size() - 4 - offsetsSize < dataSize) return truncated(bytes.size());
+    offsets = bytes.data() + 4;
+    data = bytes.substr(4 + offsetsSize, dataSize);
+    rowCount = count;
+    return {};
+}
+
+bool RowDictionary::row(uint32_t id, std::string_view& bytes) const {
+    if (id >= rowCount) return false;
+    const uint64_t begin = get64(offsets + 8 * static_cast<size_t>(id));
+    const uint64_t end = get64(offsets + 8 * (static_cast<size_t>(id) + 1));
+    if (begin > end || end > data.size()) return false;
+    bytes = data.substr(begin, end - begin);
+    return true;
+}
+
+rle::Error PackReader::open(std::string_view file) {
+    data = file;
+    rowDictionary = RowDictionary();
+    if (rle::Error error = readHeader(file, file.size(), header)) return error;
+    if (!(header.flags & flagSharedRows)) return {};
+    const uint64_t rowsAt = header.tableOffset + static_cast<uint64_t>(header.levelCount) * tableEntrySize;
+    rle::Error error = rowDictionary.open(file.substr(rowsAt));
+    if (error) {
+        header.levelCount = 0;
+        error.offset += rowsAt;
+    }
+    return error;
+}
+
+TableEntry PackReader::entry(uint32_t index) const {
+    return readTableEntry(data.data() + header.tableOffset + static_cast<size_t>(index) * tableEntrySize);
+}
+
+std::string_view PackReader::record(uint32_t index) const {
+    const TableEntry table = entry(index);
+    if (table.offset > data.size() || table.length > data.size() - table.offset) return {};
+    return data.substr(table.offset, table.length);
+}
+
+PackWriter::PackWriter(bool sharedRows)
+    : shared(sharedRows)
+{
+    if (shared) rowStarts.push_back(0);
+}
+
+TableEntry PackWriter::add(int number, const rle::Level& level, std::string& out) {
+    if (!shared) {
+        const size_t start = out.size();
+        encodeLevel(level, out);
+        return append(number, out.size() - start);
+    }
+    const int rows = level.columns > 0 ? level.rows : 0;
+    const size_t start = out.size();
+    out.resize(start + recordHeaderSize + 4 * static_cast<size_t>(rows));
+    char* header = out.data() + start;
+    put32(header, static_cast<uint32_t>(rows));
+    put32(header + 4, static_cast<uint32_t>(level.columns));
+    for (int i = 0; i < 4; ++i) put32(header + 8 + 4 * i, static_cast<uint32_t>(level.nextLevel[i]));
+    for (int row = 0; row < rows; ++row) {
+        scratch.clear();
+        encodeRow(level.tiles.data() + static_cast<size_t>(row) * level.columns, level.columns, scratch);
+        put32(out.data() + start + recordHeaderSize + 4 * static_cast<size_t>(row), intern(scratch));
+    }
+    return append(number, out.size() - start);
+}
+
+rle::Error PackWriter::addRecord(int number, std::string_view record, const RowDictionary* dictionary,
+                                 std::string& out, TableEntry& entry) {
+    LevelInfo info;
+    if (rle::Error error = readLevelInfo(record, info, dictionary)) return error;
+    if (!dictionary && !shared) {
+        out.append(record);
+        entry = append(number, record.size());
+        return {};
+    }
+
+    slices.clear();
+    const size_t dataAt = recordHeaderSize + 4 * (static_cast<size_t>(info.rows) + 1);
+    for (int row = 0; row < info.rows; ++row) {
+        const size_t at = recordHeaderSize + 4 * static_cast<size_t>(row);
+        std::string_view bytes;
+        if (dictionary) {
+            if (!dictionary->row(get32(record.data() + at), bytes)) return {rle::ErrorCode::BadFormat, at, row, 0};
+        }
+        else {
+            const size_t begin = dataAt + get32(record.data() + at);
+            const size_t end = dataAt + get32(record.data() + at + 4);
+            if (begin > end || end > record.size()) return truncated(record.size(), row);
+            bytes = record.substr(begin, end - begin);
+        }
+        slices.push_back(bytes);
+    }
+
+    const size_t start = out.size();
+    const size_t offsetsAt = start + recordHeaderSize;
+    out.append(record.substr(0, recordHeaderSize));
+    if (shared) {
+        out.resize(offsetsAt + 4 * slices.size());
+        for (size_t row = 0; row < slices.size(); ++row) put32(out.data() + offsetsAt + 4 * row, intern(slices[row]));
+    }
+    else {
+        out.resize(offsetsAt + 4 * (slices.size() + 1));
+        const size_t rowsAt = out.size();
+        for (size_t row = 0; row < slices.size(); ++row) {
+            put32(out.data() + offsetsAt + 4 * row, static_cast<uint32_t>(out.size() - rowsAt));
+            out.append(slices[row]);
+        }
+        put32(out.data() + offsetsAt + 4 * slices.size(), static_cast<uint32_t>(out.size() - rowsAt));
+    }
+    entry = append(number, out.size() - start);
+    return {};
+}
+
+void PackWriter::finish(std::string& out, char header[headerSize]) {
+    Header pack;
+    pack.flags = shared ? flagSharedRows : 0;
+    pack.levelCount = static_cast<uint32_t>(table.size() / tableEntrySize);
+    pack.tableOffset = position;
+    writeHeader(pack, header);
+    out += table;
+    if (!shared) return;
+    const size_t at = out.size();
+    out.resize(at + 4 + 8 * rowStarts.size());
+    put32(out.data() + at, static_cast<uint32_t>(rowStarts.size() - 1));
+    for (size_t i = 0; i < rowStarts.size(); ++i) put64(out.data() + at + 4 + 8 * i, rowStarts[i]);
+    out += rowData;
+}
+
+uint32_t PackWriter::intern(std::string_view row) {
+    if (2 * rowHashes.size() >= slots.size()) growSlots();
+    const uint64_t hash = hashRow(row);
+    const size_t mask = slots.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        if (slots[slot] == 0) {
+            const auto id = static_cast<uint32_t>(rowHashes.size());
+            slots[slot] = id + 1;
+            rowHashes.push_back(hash);
+            rowData.append(row);
+            rowStarts.push_back(rowData.size());
+            return id;
+        }
+        const uint32_t id = slots[slot] - 1;
+        const uint64_t begin = rowStarts[id];
+        if (rowHashes[id] == hash && rowStarts[id + 1] - begin == row.size()
+            && rowData.compare(begin, row.size(), row) == 0)
+            return id;
+    }
+}
+
+void PackWriter::growSlots() {
+    slots.assign(std::max<size_t>(1024, 2 * slots.size()), 0);
+    const size_t mask = slots.size() - 1;
+    for (size_t id = 0; id < rowHashes.size(); ++id) {
+        size_t slot = rowHashes[id] & mask;
+        while (slots[slot] != 0) slot = (slot + 1) & mask;
+        slots[slot] = static_cast<uint32_t>(id + 1);
+    }
+}
+
+TableEntry PackWriter::append(int number, size_t length) {
+    const TableEntry entry{position, static_cast<uint32_t>(length), number};
+    char bytes[tableEntrySize];
+    writeTableEntry(entry, bytes);
+    table.append(bytes, sizeof(bytes));
+    position += length;
+    return entry;
+}
+
+} // namespace rlb
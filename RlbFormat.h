@@ -0,0 +1,152 @@
+#ifndef RLBFORMAT_H
+#define RLBFORMAT_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "RleCodec.h"
+
+// Binary level pack (.rlb), all integers little-endian:
+//
+//   header       "RLB1", u16 version, u16 flags, u32 level count, u64 table offset, u32 reserved
+//   levels       one record per level, anywhere in the file
+//   table        per level: u64 record offset, u32 record length, i32 level number
+//   shared rows  only with flagSharedRows, right after the table: u32 row count,
+//                u64 row offsets[count + 1] relative to the first row, row data
+//
+//   record       u32 rows, u32 columns, i32 next_level[4], u32 row offsets[rows + 1], row data
+//                with flagSharedRows: u32 rows, u32 columns, i32 next_level[4], u32 row ids[rows]
+//   row data     per row, runs of: a tile byte below 0x80 (one tile), or 0x80|tile
+//                followed by a varint run length (0xFF escapes tiles >= 0x7F with a raw
+//                tile byte); row offsets are relative to the start of row data
+//
+// Any level, and any row range inside it, can be decoded from the table without
+// touching other records. With flagSharedRows every distinct encoded row is stored
+// once for the whole pack and records refer to rows by id, which shrinks packs whose
+// levels repeat rows (borders, floors, empty sky) without making a level slower to
+// reach: decoding it still reads only its own record and its rows.
+namespace rlb {
+
+constexpr char magic[4] = {'R', 'L', 'B', '1'};
+constexpr uint16_t formatVersion = 1;
+constexpr size_t headerSize = 24;
+constexpr size_t tableEntrySize = 16;
+constexpr size_t recordHeaderSize = 24;
+constexpr uint16_t flagSharedRows = 1;
+
+struct Header {
+    uint16_t version = formatVersion;
+    uint16_t flags = 0;
+    uint32_t levelCount = 0;
+    uint64_t tableOffset = 0;
+};
+
+struct TableEntry {
+    uint64_t offset = 0;
+    uint32_t length = 0;
+    int32_t number = 0;
+};
+
+struct LevelInfo {
+    int rows = 0;
+    int columns = 0;
+    int nextLevel[4] = {0, 0, 0, 0};
+};
+
+bool isRlb(std::string_view file);
+void writeHeader(const Header& header, char out[headerSize]);
+void writeTableEntry(const TableEntry& entry, char out[tableEntrySize]);
+// Parses the first headerSize bytes of a file of fileSize bytes, checking that the
+// level table fits in it.
+rle::Error readHeader(std::string_view bytes, uint64_t fileSize, Header& header);
+TableEntry readTableEntry(const char in[tableEntrySize]);
+
+void encodeLevel(const char* tiles, int rows, int columns, const int nextLevel[4], std::string& out);
+inline void encodeLevel(const rle::Level& level, std::string& out) {
+    encodeLevel(level.tiles.data(), level.rows, level.columns, level.nextLevel, out);
+}
+
+// The shared rows section of a pack with flagSharedRows.
+class RowDictionary
+{
+public:
+    // bytes starts at the row count; anything after the row data is ignored.
+    rle::Error open(std::string_view bytes);
+
+    uint32_t count() const { return rowCount; }
+    // False for an id past the end or offsets outside the row data.
+    bool row(uint32_t id, std::string_view& bytes) const;
+
+private:
+    const char* offsets = nullptr;
+    std::string_view data;
+    uint32_t rowCount = 0;
+};
+
+// Records of a pack with flagSharedRows need its dictionary, records of other packs nullptr.
+rle::Error readLevelInfo(std::string_view record, LevelInfo& info, const RowDictionary* dictionary = nullptr);
+rle::Error decodeLevel(std::string_view record, rle::Level& level, const RowDictionary* dictionary = nullptr);
+// Decodes rows [firstRow, firstRow + rowCount) into level, which ends up rowCount rows tall.
+rle::Error decodeRows(std::string_view record, int firstRow, int rowCount, rle::Level& level,
+                      const RowDictionary* dictionary = nullptr);
+
+// Read-only view over a whole .rlb file held in memory or mapped.
+class PackReader
+{
+public:
+    rle::Error open(std::string_view file);
+
+    uint32_t count() const { return header.levelCount; }
+    TableEntry entry(uint32_t index) const;
+    std::string_view record(uint32_t index) const;
+    // The dictionary to decode records with, nullptr unless the pack has flagSharedRows.
+    const RowDictionary* rows() const { return header.flags & flagSharedRows ? &rowDictionary : nullptr; }
+    rle::Error decode(uint32_t index, rle::Level& level) const { return decodeLevel(record(index), level, rows()); }
+
+private:
+    std::string_view data;
+    Header header;
+    RowDictionary rowDictionary;
+};
+
+// Lays out a .rlb pack front to back for writers that stream it: the caller starts
+// with headerSize bytes of room, appends each record with add() or addRecord(),
+// writes out whenever it likes, and after finish() writes the header at offset 0.
+// With sharedRows the distinct rows are kept in memory until finish() appends them.
+class PackWriter
+{
+public:
+    explicit PackWriter(bool sharedRows = false);
+
+    bool sharedRows() const { return shared; }
+    // Appends the record of a level to out and returns its table entry.
+    TableEntry add(int number, const rle::Level& level, std::string& out);
+    // Appends a record read from another .rlb pack without decoding its tiles: its rows
+    // are copied or interned as this pack stores them.
+    rle::Error addRecord(int number, std::string_view record, const RowDictionary* dictionary, std::string& out,
+                         TableEntry& entry);
+    // Appends the level table and the shared rows, and fills in the header.
+    void finish(std::string& out, char header[headerSize]);
+
+private:
+    uint32_t intern(std::string_view row);
+    void growSlots();
+    TableEntry append(int number, size_t length);
+
+    bool shared = false;
+    uint64_t position = headerSize;
+    std::string table;
+    std::vector<std::string_view> slices;
+    std::string scratch;
+    // Shared rows back to back, their start offsets (and the end) and hashes, and an
+    // open-addressed table of id + 1 per slot, 0 for a free one.
+    std::string rowData;
+    std::vector<uint64_t> rowStarts;
+    std::vector<uint64_t> rowHashes;
+    std::vector<uint32_t> slots;
+};
+
+} // namespace rlb
+
+#endif // RLBFORMAT_H
@@ -0,0 +1,110 @@
+// rlb-format-test: reads .rlb packs written by PackWriter back through PackReader,
+// and checks that records with out-of-range sizes are reported as errors.
+//
+//   rlb-format-test
+//
+// Exit code 0 when every pack reads back and every bad record is rejected, 1 otherwise.
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "LevelGenerator.h"
+#include "RlbFormat.h"
+
+namespace {
+
+int failures = 0;
+
+void fail(const std::string& what) {
+    ++failures;
+    std::cerr << "rlb-format-test: " << what << '\n';
+}
+
+void put32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>(value >> (8 * i)));
+}
+
+std::string packOf(const std::vector<rle::Level>& levels, bool sharedRows) {
+    rlb::PackWriter packWriter(sharedRows);
+    std::string out(rlb::headerSize, '\0');
+    for (size_t i = 0; i < levels.size(); ++i) packWriter.add(static_cast<int>(i) + 1, levels[i], out);
+    char header[rlb::headerSize];
+    packWriter.finish(out, header);
+    out.replace(0, rlb::headerSize, header, rlb::headerSize);
+    return out;
+}
+
+void checkRoundTrip(bool sharedRows) {
+    const std::vector<rle::Level> levels = levelgen::generatePack(50, 20, 48, 3);
+    const std::string pack = packOf(levels, sharedRows);
+    const std::string name = sharedRows ? "shared-rows pack" : "pack";
+    rlb::PackReader reader;
+    if (rle::Error error = reader.open(pack)) {
+        fail(name + ": " + rle::describe(error));
+        return;
+    }
+    if (reader.count() != levels.size()) fail(name + ": " + std::to_string(reader.count()) + " levels");
+    for (uint32_t i = 0; i < reader.count() && i < levels.size(); ++i) {
+        rle::Level level;
+        if (rle::Error error = reader.decode(i, level)) fail(name + ", level " + std::to_string(i + 1) + ": " + rle::describe(error));
+        else if (level.rows != levels[i].rows || level.columns != levels[i].columns || level.tiles != levels[i].tiles
+                 || reader.entry(i).number != static_cast<int32_t>(i) + 1)
+            fail(name + ", level " + std::to_string(i + 1) + " differs");
+    }
+}
+
+// A one-level pack whose record claims rows x columns and holds an empty row table.
+std::string packWithSize(uint32_t rows, uint32_t columns) {
+    std::string record;
+    put32(record, rows);
+    put32(record, columns);
+    for (int i = 0; i < 4; ++i) put32(record, 0);
+    put32(record, 0);
+
+    std::string out(rlb::headerSize, '\0');
+    out += record;
+    rlb::Header header;
+    header.levelCount = 1;
+    header.tableOffset = out.size();
+    char entry[rlb::tableEntrySize];
+    rlb::writeTableEntry({rlb::headerSize, static_cast<uint32_t>(record.size()), 1}, entry);
+    out.append(entry, sizeof(entry));
+    rlb::writeHeader(header, out.data());
+    return out;
+}
+
+void checkRejected(uint32_t rows, uint32_t columns) {
+    const std::string name = std::to_string(rows) + "x" + std::to_string(columns) + " record";
+    const std::string pack = packWithSize(rows, columns);
+    rlb::PackReader reader;
+    if (rle::Error error = reader.open(pack)) {
+        fail(name + ": pack does not open: " + rle::describe(error));
+        return;
+    }
+    rlb::LevelInfo info;
+    rle::Level level;
+    if (rle::Error error = rlb::readLevelInfo(reader.record(0), info); error.code != rle::ErrorCode::LevelTooLarge)
+        fail(name + ": readLevelInfo accepts it");
+    if (rle::Error error = reader.decode(0, level); error.code != rle::ErrorCode::LevelTooLarge)
+        fail(name + ": decodeLevel accepts it");
+    if (rle::Error error = rlb::decodeRows(reader.record(0), 0, 0, level); error.code != rle::ErrorCode::LevelTooLarge)
+        fail(name + ": decodeRows accepts it");
+}
+
+} // namespace
+
+int main() {
+    checkRoundTrip(false);
+    checkRoundTrip(true);
+
+    // Sizes that pass the tile limit only because the other side is zero, or that
+    // overflow it outright.
+    checkRejected(0, 0x80000000u);
+    checkRejected(0x80000000u, 0);
+    checkRejected(0, 0xFFFFFFFFu);
+    checkRejected(0x10000u, 0x10000u);
+
+    std::cout << failures << " failures\n";
+    return failures == 0 ? 0 : 1;
+}
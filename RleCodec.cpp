@@ -0,0 +1,356 @@
+#include "RleCodec.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <climits>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define RLE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define RLE_TARGET_AVX2
+#else
+#define RLE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace rle {
+
+namespace {
+
+constexpr size_t linksBound = 64;
+constexpr size_t maxLinksText = 256;
+constexpr std::string_view levelHeader = "; Level";
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+std::string_view trimmed(std::string_view text) {
+    while (!text.empty() && isSpace(text.front())) text.remove_prefix(1);
+    while (!text.empty() && isSpace(text.back())) text.remove_suffix(1);
+    return text;
+}
+
+char* writeRun(char* out, size_t count, char tile) {
+    if (count > 1) out = std::to_chars(out, out + 20, count).ptr;
+    *out++ = tile;
+    return out;
+}
+
+const char* scanRunScalar(const char* it, const char* end, char tile) {
+    while (it != end && *it == tile) ++it;
+    return it;
+}
+
+#ifdef RLE_X86
+inline unsigned lowestBit(unsigned mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+const char* scanRunSse2(const char* it, const char* end, char tile) {
+    const __m128i pattern = _mm_set1_epi8(tile);
+    while (end - it >= 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+        const unsigned differ = ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern))) & 0xFFFFu;
+        if (differ) return it + lowestBit(differ);
+        it += 16;
+    }
+    return scanRunScalar(it, end, tile);
+}
+
+RLE_TARGET_AVX2 const char* scanRunAvx2(const char* it, const char* end, char tile) {
+    const __m256i pattern = _mm256_set1_epi8(tile);
+    while (end - it >= 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+        const unsigned differ = ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, pattern)));
+        if (differ) return it + lowestBit(differ);
+        it += 32;
+    }
+    return scanRunSse2(it, end, tile);
+}
+
+bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+    if (!osSavesYmm || !(info[2] & (1 << 28))) return false;
+    __cpuidex(info, 7, 0);
+    return info[1] & (1 << 5);
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+SimdLevel supportedSimdLevel() {
+#ifdef RLE_X86
+    static const SimdLevel supported = cpuHasAvx2() ? SimdLevel::Avx2 : SimdLevel::Sse2;
+    return supported;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+using RunScanner = const char* (*)(const char*, const char*, char);
+
+RunScanner scannerFor(SimdLevel level) {
+    switch (level) {
+#ifdef RLE_X86
+        case SimdLevel::Avx2: return scanRunAvx2;
+        case SimdLevel::Sse2: return scanRunSse2;
+#endif
+        default:              return scanRunScalar;
+    }
+}
+
+std::atomic<SimdLevel> activeLevel{supportedSimdLevel()};
+
+void parseLinks(std::string_view text, int nextLevel[4]) {
+    const char* it = text.data();
+    const char* end = it + text.size();
+    bool failed = false;
+    for (int i = 0; i < 4; ++i) {
+        while (it != end && isSpace(*it)) ++it;
+        int value = 0;
+        if (!failed) {
+            auto [ptr, ec] = std::from_chars(it, end, value);
+            if (ec != std::errc() || (ptr != end && !isSpace(*ptr))) failed = true;
+            else it = ptr;
+        }
+        nextLevel[i] = failed ? 0 : value;
+    }
+}
+
+} // namespace
+
+const char* describe(ErrorCode code) {
+    switch (code) {
+        case ErrorCode::None:           return "no error";
+        case ErrorCode::MissingTile:    return "run length is not followed by a tile";
+        case ErrorCode::RaggedRow:      return "row width differs from the first row";
+        case ErrorCode::CountOverflow:  return "run length is too large";
+        case ErrorCode::LevelTooLarge:  return "level exceeds the maximum tile count";
+        case ErrorCode::Truncated:      return "data ends before the record is complete";
+        case ErrorCode::BadFormat:      return "not a supported level pack";
+    }
+    return "unknown error";
+}
+
+std::string describe(const Error& error) {
+    return std::string(describe(error.code)) + " at byte " + std::to_string(error.offset)
+         + " (row " + std::to_string(error.row + 1) + ", column " + std::to_string(error.column + 1) + ")";
+}
+
+SimdLevel simdLevel() {
+    return activeLevel.load(std::memory_order_relaxed);
+}
+
+void setSimdLevel(SimdLevel level) {
+    activeLevel.store(std::min(level, supportedSimdLevel()), std::memory_order_relaxed);
+}
+
+size_t encodedSizeBound(int rows, int columns) {
+    if (rows <= 0 || columns <= 0) return linksBound;
+    return static_cast<size_t>(rows) * columns + rows + linksBound;
+}
+
+size_t encode(const char* tiles, int rows, int columns, const int nextLevel[4], char* out, size_t capacity) {
+    if (capacity < encodedSizeBound(rows, columns)) return 0;
+    const RunScanner scanRun = scannerFor(simdLevel());
+    char* cursor = out;
+    for (int i = 0; i < rows && columns > 0; i++) {
+        const char* row = tiles + static_cast<size_t>(i) * columns;
+        const char* end = row + columns;
+        while (row != end) {
+            const char tile = *row;
+            const char* run = scanRun(row + 1, end, tile);
+            cursor = writeRun(cursor, run - row, tile);
+            row = run;
+        }
+        if (i < rows - 1) *cursor++ = '|';
+    }
+    *cursor++ = ':';
+    *cursor++ = ':';
+    for (int i = 0; i < 4; ++i) {
+        if (i > 0) *cursor++ = ' ';
+        cursor = std::to_chars(cursor, cursor + 11, nextLevel[i]).ptr;
+    }
+    return cursor - out;
+}
+
+void encode(const char* tiles, int rows, int columns, const int nextLevel[4], std::string& out) {
+    out.resize(encodedSizeBound(rows, columns));
+    out.resize(encode(tiles, rows, columns, nextLevel, out.data(), out.size()));
+}
+
+Decoder::Decoder(Level& target)
+    : level(target)
+{
+    level.rows = 0;
+    level.columns = 0;
+    for (int& link : level.nextLevel) link = 0;
+    level.tiles.clear();
+}
+
+Error Decoder::putTile(char tile) {
+    const size_t run = hasCount ? count : 1;
+    if (level.tiles.size() + run > maxLevelTiles) return fail(ErrorCode::LevelTooLarge);
+    // maxLevelTiles is above INT_MAX, so one row could still outgrow its int width.
+    if (run > static_cast<size_t>(INT_MAX - rowColumns)) return fail(ErrorCode::CountOverflow);
+    level.tiles.insert(level.tiles.end(), run, tile);
+    rowColumns += static_cast<int>(run);
+    hasCount = false;
+    count = 0;
+    return {};
+}
+
+Error Decoder::endRow() {
+    if (!widthKnown) {
+        level.columns = rowColumns;
+        widthKnown = true;
+    }
+    else if (level.columns != rowColumns) return fail(ErrorCode::RaggedRow);
+    level.rows++;
+    rowColumns = 0;
+    return {};
+}
+
+Error Decoder::feed(std::string_view chunk) {
+    for (const char c : chunk) {
+        if (inLinks) {
+            if (links.size() < maxLinksText) links.push_back(c);
+            ++offset;
+            continue;
+        }
+        if (pendingColon) {
+            pendingColon = false;
+            if (c == ':') {
+                if (hasCount) return fail(ErrorCode::MissingTile);
+                inLinks = true;
+                ++offset;
+                continue;
+            }
+            if (Error error = putTile(':')) return error;
+        }
+        if (c >= '0' && c <= '9') {
+            if (count > maxLevelTiles / 10) return fail(ErrorCode::CountOverflow);
+            count = count * 10 + (c - '0');
+            hasCount = true;
+        }
+        else if (c == '|') {
+            if (hasCount) return fail(ErrorCode::MissingTile);
+            if (Error error = endRow()) return error;
+        }
+        else if (c == ':') pendingColon = true;
+        else if (Error error = putTile(c)) return error;
+        ++offset;
+    }
+    return {};
+}
+
+Error Decoder::finish() {
+    if (pendingColon) {
+        pendingColon = false;
+        if (Error error = putTile(':')) return error;
+    }
+    if (hasCount) return fail(ErrorCode::MissingTile);
+    if (rowColumns > 0) {
+        if (Error error = endRow()) return error;
+    }
+    if (inLinks) parseLinks(links, level.nextLevel);
+    return {};
+}
+
+Error decode(std::string_view encoded, Level& level) {
+    Decoder decoder(level);
+    if (Error error = decoder.feed(encoded)) return error;
+    return decoder.finish();
+}
+
+std::vector<PackRecord> scanPack(std::string_view file) {
+    std::vector<PackRecord> records;
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    const char* line = begin;
+    while (line < end) {
+        const char* eol = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if (!eol) eol = end;
+        std::string_view text = trimmed(std::string_view(line, eol - line));
+        if (text.substr(0, levelHeader.size()) == levelHeader) {
+            if (!records.empty()) records.back().length = (line - begin) - records.back().offset;
+            text = trimmed(text.substr(levelHeader.size()));
+            PackRecord record;
+            std::from_chars(text.data(), text.data() + text.size(), record.number);
+            record.offset = std::min(eol + 1, end) - begin;
+            records.push_back(record);
+        }
+        line = eol + 1;
+    }
+    if (!records.empty()) records.back().length = file.size() - records.back().offset;
+    return records;
+}
+
+std::string_view recordText(std::string_view record, std::string& scratch) {
+    const std::string_view text = trimmed(record);
+    if (text.find('\n') == std::string_view::npos) return text;
+
+    scratch.clear();
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t stop = text.find('\n', start);
+        if (stop == std::string_view::npos) stop = text.size();
+        const std::string_view line = trimmed(text.substr(start, stop - start));
+        if (!line.empty()) {
+            if (!scratch.empty()) scratch += '|';
+            scratch += line;
+        }
+        start = stop + 1;
+    }
+    return scratch;
+}
+
+size_t recordOffset(std::string_view record, size_t textOffset) {
+    const std::string_view text = trimmed(record);
+    const size_t lead = text.data() - record.data();
+    if (text.find('\n') == std::string_view::npos) return lead + textOffset;
+
+    size_t joined = 0;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t stop = text.find('\n', start);
+        if (stop == std::string_view::npos) stop = text.size();
+        const std::string_view line = trimmed(text.substr(start, stop - start));
+        if (!line.empty()) {
+            if (joined > 0) ++joined;
+            if (textOffset <= joined + line.size()) return lead + (line.data() - text.data()) + (textOffset - joined);
+            joined += line.size();
+        }
+        start = stop + 1;
+    }
+    return lead + text.size();
+}
+
+void appendPackRecord(int number, std::string_view text, std::string& out) {
+    out += levelHeader;
+    out += ' ';
+    out += std::to_string(number);
+    out += '\n';
+    out += text;
+    out += "\n\n";
+}
+
+} // namespace rle
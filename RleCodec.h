@@ -0,0 +1,110 @@
+#ifndef RLECODEC_H
+#define RLECODEC_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rle {
+
+enum class ErrorCode {
+    None,
+    MissingTile,
+    RaggedRow,
+    CountOverflow,
+    LevelTooLarge,
+    Truncated,
+    BadFormat
+};
+
+struct Error {
+    ErrorCode code = ErrorCode::None;
+    size_t offset = 0;
+    int row = 0;
+    int column = 0;
+
+    explicit operator bool() const { return code != ErrorCode::None; }
+};
+
+const char* describe(ErrorCode code);
+std::string describe(const Error& error);
+
+struct Level {
+    int rows = 0;
+    int columns = 0;
+    int nextLevel[4] = {0, 0, 0, 0};
+    std::vector<char> tiles;
+};
+
+constexpr size_t maxLevelTiles = size_t(1) << 31;
+
+enum class SimdLevel {
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+// Run boundaries are found with the widest instruction set the CPU supports.
+// setSimdLevel clamps to that and exists so paths can be compared against each other.
+SimdLevel simdLevel();
+void setSimdLevel(SimdLevel level);
+
+size_t encodedSizeBound(int rows, int columns);
+
+// Encodes into a caller-provided buffer and returns the number of bytes written.
+// Returns 0 when capacity is below encodedSizeBound(rows, columns).
+size_t encode(const char* tiles, int rows, int columns, const int nextLevel[4], char* out, size_t capacity);
+void encode(const char* tiles, int rows, int columns, const int nextLevel[4], std::string& out);
+inline void encode(const Level& level, std::string& out) {
+    encode(level.tiles.data(), level.rows, level.columns, level.nextLevel, out);
+}
+
+// Incremental decoder. Input may be split at any byte; the target level keeps its
+// tile capacity between decodes, so reusing one Level does not reallocate.
+class Decoder
+{
+public:
+    explicit Decoder(Level& target);
+
+    Error feed(std::string_view chunk);
+    Error finish();
+    size_t consumed() const { return offset; }
+
+private:
+    Error fail(ErrorCode code) const { return {code, offset, level.rows, rowColumns}; }
+    Error endRow();
+    Error putTile(char tile);
+
+    Level& level;
+    size_t offset = 0;
+    size_t count = 0;
+    bool hasCount = false;
+    bool pendingColon = false;
+    bool inLinks = false;
+    bool widthKnown = false;
+    int rowColumns = 0;
+    std::string links;
+};
+
+Error decode(std::string_view encoded, Level& level);
+
+// A text pack (.rll) is a sequence of "; Level N" header lines, each followed by
+// the encoded level. Records span from the end of a header line to the next header.
+struct PackRecord {
+    int number = 0;
+    size_t offset = 0;
+    size_t length = 0;
+};
+
+std::vector<PackRecord> scanPack(std::string_view file);
+// The encoded level inside a record: trimmed, and with levels written one row per
+// line joined by '|' into scratch.
+std::string_view recordText(std::string_view record, std::string& scratch);
+// Maps an offset in recordText() back to an offset in the record.
+size_t recordOffset(std::string_view record, size_t textOffset);
+void appendPackRecord(int number, std::string_view text, std::string& out);
+
+} // namespace rle
+
+#endif // RLECODEC_H
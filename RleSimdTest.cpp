@@ -0,0 +1,148 @@
+// rle-simd-test: checks the SSE2 and AVX2 run scanners of the RLE encoder against
+// the scalar one.
+//
+//   rle-simd-test [--seed N]
+//
+// Every row is encoded once per SimdLevel the CPU supports and the outputs must
+// match byte for byte and decode back to the row. Rows are separate heap buffers
+// of their exact length, so a scanner reading past the end of a row shows up under
+// AddressSanitizer. The edge cases are single runs of every length up to 70 (the
+// 16- and 32-byte block boundaries and one either side), starting at every offset
+// within a block and ending at the tail of the row or before another tile.
+// Exit code 0 when all paths agree, 1 on a mismatch, 2 on usage errors.
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "RleCodec.h"
+
+namespace {
+
+const char* levelName(rle::SimdLevel level) {
+    switch (level) {
+        case rle::SimdLevel::Scalar: return "scalar";
+        case rle::SimdLevel::Sse2:   return "sse2";
+        case rle::SimdLevel::Avx2:   return "avx2";
+    }
+    return "unknown";
+}
+
+std::string describe(const std::string& row) {
+    std::string out;
+    for (size_t i = 0; i < row.size();) {
+        size_t run = i + 1;
+        while (run < row.size() && row[run] == row[i]) ++run;
+        if (!out.empty()) out += ' ';
+        out += std::to_string(run - i) + "x" + std::to_string(static_cast<unsigned char>(row[i]));
+        i = run;
+    }
+    return '[' + out + ']';
+}
+
+class Checker
+{
+public:
+    explicit Checker(std::vector<rle::SimdLevel> paths) : paths(std::move(paths)) {}
+
+    void check(const std::string& row) {
+        ++rows;
+        // Exactly row.size() bytes, with nothing after the row to read by mistake.
+        const std::unique_ptr<char[]> tiles(new char[row.empty() ? 1 : row.size()]);
+        std::copy(row.begin(), row.end(), tiles.get());
+        const int columns = static_cast<int>(row.size());
+        const int links[4] = {0, 0, 0, 0};
+
+        std::string expected;
+        for (size_t i = 0; i < paths.size(); ++i) {
+            rle::setSimdLevel(paths[i]);
+            std::string encoded;
+            rle::encode(tiles.get(), 1, columns, links, encoded);
+            if (i == 0) {
+                expected = encoded;
+                rle::Level level;
+                const bool same = !rle::decode(encoded, level) && (columns == 0 || level.columns == columns)
+                               && std::string(level.tiles.begin(), level.tiles.end()) == row;
+                if (!same) fail("scalar output does not decode to the row", row);
+            }
+            else if (encoded != expected) fail(std::string(levelName(paths[i])) + " differs from scalar", row);
+        }
+    }
+
+    int failures = 0;
+    size_t rows = 0;
+
+private:
+    void fail(const std::string& what, const std::string& row) {
+        if (failures++ < 20) std::cerr << "rle-simd-test: " << what << " for " << describe(row) << '\n';
+    }
+
+    std::vector<rle::SimdLevel> paths;
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        if (argument == "--seed" && i + 1 < argc) seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else {
+            std::cerr << "usage: rle-simd-test [--seed N]\n";
+            return 2;
+        }
+    }
+
+    std::vector<rle::SimdLevel> paths = {rle::SimdLevel::Scalar};
+    for (const rle::SimdLevel level : {rle::SimdLevel::Sse2, rle::SimdLevel::Avx2}) {
+        rle::setSimdLevel(level);
+        if (rle::simdLevel() == level) paths.push_back(level);
+    }
+    const rle::SimdLevel fastest = paths.back();
+    Checker checker(paths);
+
+    // One run of every length, at every offset within a 32-byte block, ending at the
+    // tail of the row or followed by another tile.
+    for (size_t length = 1; length <= 70; ++length) {
+        for (size_t offset = 0; offset <= 33; ++offset) {
+            const std::string prefix(offset, 'a');
+            const std::string run(length, 'b');
+            checker.check(prefix + run);
+            checker.check(prefix + run + 'c');
+            checker.check(prefix + run + std::string(17, 'c'));
+            // Tiles with the high bit set compare as negative bytes in the SIMD paths.
+            checker.check(prefix + std::string(length, '\xF0') + '\x7F');
+        }
+    }
+    // A run that breaks one byte before, at and after each block boundary.
+    for (size_t length : {15, 16, 17, 31, 32, 33, 47, 48, 49, 63, 64, 65}) {
+        for (size_t tail = 0; tail <= 2; ++tail) checker.check(std::string(length, 'x') + std::string(tail, 'y'));
+    }
+    checker.check({});
+
+    std::mt19937 random(seed);
+    const std::string alphabets[] = {"ab", "abc", "-#", "abcdefgh", std::string("\x01\x80\xFF-", 4)};
+    for (int i = 0; i < 20000; ++i) {
+        const std::string& alphabet = alphabets[random() % std::size(alphabets)];
+        const size_t length = random() % 300;
+        // Long runs are what the SIMD paths skip through; short ones hit the scalar tails.
+        const uint32_t keep = random() % 100;
+        std::string row;
+        char tile = alphabet[random() % alphabet.size()];
+        while (row.size() < length) {
+            if (random() % 100 >= keep) tile = alphabet[random() % alphabet.size()];
+            row += tile;
+        }
+        checker.check(row);
+    }
+
+    rle::setSimdLevel(fastest);
+    std::cout << checker.rows << " rows, paths:";
+    for (const rle::SimdLevel level : paths) std::cout << ' ' << levelName(level);
+    std::cout << ", " << checker.failures << " failures\n";
+    return checker.failures == 0 ? 0 : 1;
+}
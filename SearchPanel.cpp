@@ -0,0 +1,139 @@
+#include "SearchPanel.h"
+
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+
+namespace {
+
+constexpr int numberRole = Qt::UserRole;
+constexpr int indexRole = Qt::UserRole + 1;
+constexpr int cellsRole = Qt::UserRole + 2;
+
+// Results arrive in whatever order the workers finish; sorting puts them back in pack order.
+class LevelItem : public QTreeWidgetItem
+{
+public:
+    using QTreeWidgetItem::QTreeWidgetItem;
+
+    bool operator<(const QTreeWidgetItem& other) const override {
+        return data(0, indexRole).toInt() < other.data(0, indexRole).toInt();
+    }
+};
+
+} // namespace
+
+SearchPanel::SearchPanel(QWidget *parent)
+    : QWidget(parent)
+{
+    auto* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    patternEdit = new QPlainTextEdit;
+    patternEdit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    patternEdit->setPlaceholderText("Tile pattern, one row per line; ? matches any tile");
+    patternEdit->setMaximumHeight(patternEdit->fontMetrics().lineSpacing() * 6);
+    layout->addWidget(patternEdit);
+
+    auto* buttons = new QHBoxLayout;
+    auto* selectionButton = new QPushButton("Use selection");
+    selectionButton->setToolTip("Search for the tiles in the selection");
+    connect(selectionButton, &QPushButton::clicked, this, [this] {
+        const QString text = selectionSource ? selectionSource() : QString();
+        if (!text.isEmpty()) patternEdit->setPlainText(text);
+    });
+    buttons->addWidget(selectionButton);
+    searchButton = new QPushButton;
+    connect(searchButton, &QPushButton::clicked, this, &SearchPanel::startOrStop);
+    buttons->addWidget(searchButton);
+    layout->addLayout(buttons);
+
+    status = new QLabel;
+    status->setWordWrap(true);
+    layout->addWidget(status);
+
+    results = new QTreeWidget;
+    results->setHeaderHidden(true);
+    results->setUniformRowHeights(true);
+    const auto activate = [this](QTreeWidgetItem* item) {
+        const QVariant number = item->data(0, numberRole);
+        if (number.isValid() && activated) activated(number.toInt(), item->data(0, cellsRole).toRect());
+    };
+    connect(results, &QTreeWidget::itemClicked, this, activate);
+    connect(results, &QTreeWidget::itemActivated, this, activate);
+    layout->addWidget(results, 1);
+    setRunning(false);
+}
+
+void SearchPanel::startOrStop() {
+    if (running) {
+        if (stopHandler) stopHandler();
+        setRunning(false);
+        status->setText(status->text() + " (stopped)");
+        return;
+    }
+    PatternMatcher matcher;
+    std::string error;
+    if (!matcher.setPattern(patternEdit->toPlainText().toStdString(), error)) {
+        status->setText(QString::fromStdString(error));
+        return;
+    }
+    reset();
+    patternSize = QSize(matcher.columns(), matcher.rows());
+    setRunning(true);
+    updateStatus();
+    if (searchHandler) searchHandler(matcher);
+}
+
+void SearchPanel::setRunning(bool value) {
+    running = value;
+    searchButton->setText(running ? "Stop" : "Search");
+}
+
+void SearchPanel::reset() {
+    results->clear();
+    matchedLevels = 0;
+    matchCount = 0;
+    if (running) setRunning(false);
+    status->clear();
+}
+
+void SearchPanel::addResults(const std::vector<PatternSearch::LevelMatches>& found) {
+    if (!running) return;
+    results->setUpdatesEnabled(false);
+    for (const PatternSearch::LevelMatches& level : found) {
+        auto* item = new LevelItem(results);
+        item->setText(0, QString("Level %1 (%2 %3)").arg(level.number).arg(level.count).arg(level.count == 1 ? "match" : "matches"));
+        item->setData(0, numberRole, level.number);
+        item->setData(0, indexRole, level.index);
+        for (const PatternMatcher::Match& match : level.matches) {
+            const QRect cells(QPoint(match.column, match.row), patternSize);
+            auto* child = new QTreeWidgetItem(item, {QString("Row %1, column %2").arg(match.row + 1).arg(match.column + 1)});
+            child->setData(0, numberRole, level.number);
+            child->setData(0, cellsRole, cells);
+            if (&match == &level.matches.front()) item->setData(0, cellsRole, cells);
+        }
+        if (level.count > level.matches.size())
+            new QTreeWidgetItem(item, {QString("... and %1 more").arg(level.count - level.matches.size())});
+        ++matchedLevels;
+        matchCount += level.count;
+    }
+    results->setUpdatesEnabled(true);
+    updateStatus();
+}
+
+void SearchPanel::searchFinished(const PatternSearch::Summary& summary) {
+    if (!running) return;
+    setRunning(false);
+    results->sortItems(0, Qt::AscendingOrder);
+    QString text = QString("%1 %2 in %3 of %4 levels (%5 s)")
+                       .arg(summary.matches).arg(summary.matches == 1 ? "match" : "matches")
+                       .arg(matchedLevels).arg(summary.levels).arg(summary.milliseconds / 1000.0, 0, 'f', 2);
+    if (summary.failedLevels > 0) text += QString("\n%1 levels could not be decoded").arg(summary.failedLevels);
+    status->setText(text);
+}
+
+void SearchPanel::updateStatus() {
+    status->setText(QString("Searching... %1 %2 in %3 levels so far")
+                        .arg(matchCount).arg(matchCount == 1 ? "match" : "matches").arg(matchedLevels));
+}
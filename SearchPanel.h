@@ -0,0 +1,52 @@
+#ifndef SEARCHPANEL_H
+#define SEARCHPANEL_H
+
+#include <QLabel>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <functional>
+#include <vector>
+#include "PatternMatcher.h"
+#include "PatternSearch.h"
+
+// Pattern search over the level pack: a tile pattern typed one row per line, '?'
+// matching any tile, and the levels it occurs in, filled in while the search runs.
+// Activating a match passes its level number and cells to the activation handler.
+class SearchPanel : public QWidget
+{
+public:
+    explicit SearchPanel(QWidget *parent = nullptr);
+
+    // Called with a valid pattern when the user starts a search.
+    void setSearchHandler(std::function<void(const PatternMatcher&)> handler) { searchHandler = std::move(handler); }
+    void setStopHandler(std::function<void()> handler) { stopHandler = std::move(handler); }
+    // Supplies the pattern text for "Use selection"; an empty string leaves the pattern alone.
+    void setSelectionSource(std::function<QString()> source) { selectionSource = std::move(source); }
+    void setMatchActivatedHandler(std::function<void(int, const QRect&)> handler) { activated = std::move(handler); }
+
+    void addResults(const std::vector<PatternSearch::LevelMatches>& results);
+    void searchFinished(const PatternSearch::Summary& summary);
+    // Forgets the results, e.g. when they no longer describe the loaded pack.
+    void reset();
+
+private:
+    void startOrStop();
+    void setRunning(bool running);
+    void updateStatus();
+
+    QPlainTextEdit* patternEdit;
+    QPushButton* searchButton;
+    QLabel* status;
+    QTreeWidget* results;
+    QSize patternSize;
+    bool running = false;
+    int matchedLevels = 0;
+    size_t matchCount = 0;
+    std::function<void(const PatternMatcher&)> searchHandler;
+    std::function<void()> stopHandler;
+    std::function<QString()> selectionSource;
+    std::function<void(int, const QRect&)> activated;
+};
+
+#endif // SEARCHPANEL_H
@@ -0,0 +1,36 @@
+#ifndef TILECLIPBOARD_H
+#define TILECLIPBOARD_H
+
+#include <QClipboard>
+#include <QGuiApplication>
+#include <QMimeData>
+#include "TileMap.h"
+#include "utilities.h"
+
+// Regions go through the system clipboard RLE-encoded exactly like a level without
+// next-level links, so they can be pasted into any level of any editor instance.
+inline constexpr char tileRegionMimeType[] = "application/x-platformer-tiles";
+
+inline void copyTilesToClipboard(const TileMap& tiles) {
+    const int noLinks[4] = {0, 0, 0, 0};
+    QByteArray encoded;
+    encrypt(tiles.rows(), tiles.columns(), tiles.toVector(), noLinks, encoded);
+    auto* data = new QMimeData;
+    data->setData(tileRegionMimeType, encoded);
+    data->setText(QString::fromLatin1(encoded));
+    QGuiApplication::clipboard()->setMimeData(data);
+}
+
+// Also accepts plain text holding one encoded level.
+inline bool tilesFromClipboard(TileMap& tiles) {
+    const QMimeData* data = QGuiApplication::clipboard()->mimeData();
+    if (!data) return false;
+    const QByteArray encoded = data->hasFormat(tileRegionMimeType) ? data->data(tileRegionMimeType) : data->text().trimmed().toLatin1();
+    int rows = 0, columns = 0, links[4];
+    std::vector<char> decoded;
+    if (encoded.isEmpty() || !decrypt(encoded, rows, columns, links, decoded)) return false;
+    tiles = TileMap(rows, columns, decoded);
+    return !tiles.isEmpty();
+}
+
+#endif // TILECLIPBOARD_H
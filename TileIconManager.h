@@ -4,7 +4,12 @@
 #include <QMap>
 #include <QPushButton>
 #include <QIcon>
+#include <QImage>
+#include <QPixmap>
 #include <QString>
+#include <algorithm>
+#include <array>
+#include <deque>
 
 enum class TileType {
     Air,
@@ -18,46 +23,121 @@ enum class TileType {
     PlayerUp,
     PlayerDown,
     Platform,
-    Spring
+    Spring,
+    Exit
+};
+
+struct TileInfo {
+    TileType type;
+    char symbol;
+    const char* sprite;
+};
+
+inline constexpr TileInfo tileTable[] = {
+    {TileType::Air,         '-', "data/sprites/air.png"},
+    {TileType::Wall,        '#', "data/sprites/wall.png"},
+    {TileType::DarkWall,    '=', "data/sprites/wall_dark.png"},
+    {TileType::Coin,        '*', "data/sprites/coin.png"},
+    {TileType::Spikes,      '^', "data/sprites/spikes.png"},
+    {TileType::Enemy,       '&', "data/sprites/enemy.png"},
+    {TileType::PlayerLeft,  'L', "data/sprites/player_left.png"},
+    {TileType::PlayerRight, 'R', "data/sprites/player_right.png"},
+    {TileType::PlayerUp,    'U', "data/sprites/player_up.png"},
+    {TileType::PlayerDown,  'D', "data/sprites/player_down.png"},
+    {TileType::Platform,    'P', "data/sprites/platform.png"},
+    {TileType::Spring,      'S', "data/sprites/spring.png"},
+    {TileType::Exit,        'E', "data/sprites/exit.png"},
 };
 
 class TileIconManager
 {
 public:
-    TileIconManager() = default;
+    TileIconManager() {
+        // Unknown tiles stand out in zoomed-out views.
+        tileColors.fill(qRgb(255, 0, 255));
+        for (const TileInfo& info : tileTable) {
+            const auto index = static_cast<unsigned char>(info.symbol);
+            atlas[index] = QPixmap(info.sprite);
+            tileColors[index] = averageColor(atlas[index]);
+        }
+    }
     ~TileIconManager() = default;
 
-    void registerButton(TileType type, const QString& path, QPushButton* button) {
-        iconPaths[type] = path;
+    static const TileInfo& info(TileType type) { return tileTable[static_cast<int>(type)]; }
+    static char symbol(TileType type) { return info(type).symbol; }
+
+    void registerButton(TileType type, QPushButton* button) {
         buttons[type] = button;
     }
 
     void scaleIcons(const QSize& size) {
+        if (size == buttonIconSize) return;
+        buttonIconSize = size;
         for (auto it = buttons.begin(); it != buttons.end(); ++it) {
-            TileType type = it.key();
             QPushButton* button = it.value();
-            QString path = iconPaths.value(type);
-            QIcon icon = getScaledIcon(path, size);
-            button->setIcon(icon);
+            button->setIcon(QIcon(pixmap(symbol(it.key()), size.width())));
             button->setIconSize(size);
         }
     }
 
-    static QIcon getScaledIcon(const QString& path, const QSize& size) {
-        if (path.isEmpty()) return {};
-        QPixmap pixmap(path);
-        if (pixmap.isNull()) return {};
-        return {pixmap.scaled(size, Qt::KeepAspectRatio, Qt::FastTransformation)};
+    // Sprites are decoded once into the atlas; scaled copies are cached per size and
+    // only rebuilt when a caller asks for a size that is not among the recent ones.
+    const QPixmap& pixmap(char tile, int size) const {
+        auto cache = std::find_if(scaled.begin(), scaled.end(), [size](const ScaledSet& set) { return set.size == size; });
+        if (cache == scaled.end()) {
+            if (scaled.size() == maxScaledSets) scaled.pop_front();
+            scaled.push_back({size, {}, {}});
+            cache = scaled.end() - 1;
+        }
+        const auto index = static_cast<unsigned char>(tile);
+        if (!cache->ready[index]) {
+            const QPixmap& source = atlas[index];
+            if (!source.isNull()) cache->pixmaps[index] = source.scaled(size, size, Qt::KeepAspectRatio, Qt::FastTransformation);
+            cache->ready[index] = true;
+        }
+        return cache->pixmaps[index];
     }
 
+    // One representative color per tile, used when tiles are too small for sprites.
+    QRgb color(char tile) const { return tileColors[static_cast<unsigned char>(tile)]; }
+    const std::array<QRgb, 256>& colors() const { return tileColors; }
+
     void updateButtonStyles(const TileType selectedTile) {
         for (const auto button : buttons) button->setStyleSheet("");
         if (QPushButton* activeButton = buttons[selectedTile]) activeButton->setStyleSheet("background-color: yellow;");
     }
 
 private:
-    QMap<TileType, QString> iconPaths;
+    struct ScaledSet {
+        int size;
+        std::array<QPixmap, 256> pixmaps;
+        std::array<bool, 256> ready;
+    };
+    static constexpr size_t maxScaledSets = 4;
+
+    // Mean of the sprite composited over white, which is what a tiny sprite looks like.
+    static QRgb averageColor(const QPixmap& sprite) {
+        const QImage image = sprite.toImage().convertToFormat(QImage::Format_ARGB32);
+        if (image.isNull()) return qRgb(255, 255, 255);
+        quint64 red = 0, green = 0, blue = 0;
+        for (int y = 0; y < image.height(); ++y) {
+            const auto* line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+            for (int x = 0; x < image.width(); ++x) {
+                const int alpha = qAlpha(line[x]);
+                red += (qRed(line[x]) * alpha + 255 * (255 - alpha)) / 255;
+                green += (qGreen(line[x]) * alpha + 255 * (255 - alpha)) / 255;
+                blue += (qBlue(line[x]) * alpha + 255 * (255 - alpha)) / 255;
+            }
+        }
+        const quint64 pixels = quint64(image.width()) * image.height();
+        return qRgb(int(red / pixels), int(green / pixels), int(blue / pixels));
+    }
+
+    std::array<QPixmap, 256> atlas;
+    std::array<QRgb, 256> tileColors;
+    mutable std::deque<ScaledSet> scaled;
     QMap<TileType, QPushButton*> buttons;
+    QSize buttonIconSize;
 };
 
-#endif // TILEICONMANAGER_H
\ No newline at end of file
+#endif // TILEICONMANAGER_H
@@ -0,0 +1,146 @@
+#include "TileMap.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+int chunksFor(int cells) {
+    return (cells + TileMap::chunkSize - 1) >> TileMap::chunkShift;
+}
+
+} // namespace
+
+TileMap::TileMap(int rows, int columns, char tile)
+    : rowCount(rows), columnCount(columns), chunkColumns(chunksFor(columns)),
+      chunks(static_cast<size_t>(chunksFor(rows)) * chunkColumns)
+{
+    fill(tile);
+}
+
+TileMap::TileMap(int rows, int columns, const std::vector<char>& data)
+    : TileMap(rows, columns)
+{
+    const size_t available = data.size();
+    for (int row = 0; row < rows; ++row) {
+        const size_t start = static_cast<size_t>(row) * columns;
+        if (start >= available) break;
+        writeRow(row, 0, static_cast<int>(std::min<size_t>(columns, available - start)), data.data() + start);
+    }
+}
+
+TileMap::Chunk& TileMap::writableChunk(size_t index) {
+    std::shared_ptr<Chunk>& chunk = chunks[index];
+    if (!chunk) {
+        chunk = std::make_shared<Chunk>();
+        chunk->fill(air);
+    }
+    // Another copy of the map may be reading this chunk on another thread.
+    else if (chunk.use_count() > 1) chunk = std::make_shared<Chunk>(*chunk);
+    return *chunk;
+}
+
+void TileMap::set(int row, int col, char tile) {
+    const size_t index = chunkIndex(row, col);
+    if (!chunks[index] && tile == air) return;
+    writableChunk(index)[cellIndex(row, col)] = tile;
+}
+
+void TileMap::readRow(int row, int col, int count, char* out) const {
+    while (count > 0) {
+        const int length = std::min(count, chunkSize - (col & (chunkSize - 1)));
+        const Chunk* chunk = chunks[chunkIndex(row, col)].get();
+        if (chunk) std::memcpy(out, chunk->data() + cellIndex(row, col), length);
+        else std::memset(out, air, length);
+        out += length;
+        col += length;
+        count -= length;
+    }
+}
+
+void TileMap::writeRow(int row, int col, int count, const char* tiles) {
+    while (count > 0) {
+        const int length = std::min(count, chunkSize - (col & (chunkSize - 1)));
+        const size_t index = chunkIndex(row, col);
+        if (chunks[index] || std::any_of(tiles, tiles + length, [](char tile) { return tile != air; }))
+            std::memcpy(writableChunk(index).data() + cellIndex(row, col), tiles, length);
+        tiles += length;
+        col += length;
+        count -= length;
+    }
+}
+
+void TileMap::fillRow(int row, int col, int count, char tile) {
+    while (count > 0) {
+        const int length = std::min(count, chunkSize - (col & (chunkSize - 1)));
+        const size_t index = chunkIndex(row, col);
+        if (chunks[index] || tile != air) std::memset(writableChunk(index).data() + cellIndex(row, col), tile, length);
+        col += length;
+        count -= length;
+    }
+}
+
+TileMap TileMap::region(int row, int col, int rows, int columns) const {
+    TileMap copy(rows, columns);
+    const int first = std::max(col, 0);
+    const int last = std::min(col + columns, columnCount) - 1;
+    if (first > last) return copy;
+    std::vector<char> line(static_cast<size_t>(last - first + 1));
+    for (int r = std::max(row, 0); r < std::min(row + rows, rowCount); ++r) {
+        readRow(r, first, last - first + 1, line.data());
+        copy.writeRow(r - row, first - col, last - first + 1, line.data());
+    }
+    return copy;
+}
+
+void TileMap::paste(const TileMap& tiles, int row, int col) {
+    const int first = std::max(col, 0);
+    const int last = std::min(col + tiles.columns(), columnCount) - 1;
+    if (first > last) return;
+    std::vector<char> line(static_cast<size_t>(last - first + 1));
+    for (int r = std::max(row, 0); r < std::min(row + tiles.rows(), rowCount); ++r) {
+        tiles.readRow(r - row, first - col, last - first + 1, line.data());
+        writeRow(r, first, last - first + 1, line.data());
+    }
+}
+
+void TileMap::fill(char tile) {
+    // Every chunk shares one filled chunk until it is written to.
+    std::shared_ptr<Chunk> filled;
+    if (tile != air) {
+        filled = std::make_shared<Chunk>();
+        filled->fill(tile);
+    }
+    std::fill(chunks.begin(), chunks.end(), filled);
+}
+
+void TileMap::resize(int rows, int columns) {
+    const int keptRows = std::min(rows, rowCount);
+    const int keptColumns = std::min(columns, columnCount);
+    const int newChunkColumns = chunksFor(columns);
+    std::vector<std::shared_ptr<Chunk>> resized(static_cast<size_t>(chunksFor(rows)) * newChunkColumns);
+    for (int chunkRow = 0; chunkRow < chunksFor(keptRows); ++chunkRow) {
+        for (int chunkCol = 0; chunkCol < chunksFor(keptColumns); ++chunkCol)
+            resized[static_cast<size_t>(chunkRow) * newChunkColumns + chunkCol] = chunks[static_cast<size_t>(chunkRow) * chunkColumns + chunkCol];
+    }
+    rowCount = rows;
+    columnCount = columns;
+    chunkColumns = newChunkColumns;
+    chunks.swap(resized);
+
+    // Kept edge chunks still hold the tiles that were cut off, so clear what is uncovered.
+    const int edgeRows = std::min(rows, chunksFor(keptRows) << chunkShift);
+    const int edgeColumns = std::min(columns, chunksFor(keptColumns) << chunkShift);
+    for (int row = 0; row < keptRows && keptColumns < edgeColumns; ++row) fillRow(row, keptColumns, edgeColumns - keptColumns, air);
+    for (int row = keptRows; row < edgeRows; ++row) fillRow(row, 0, edgeColumns, air);
+}
+
+std::vector<char> TileMap::toVector() const {
+    std::vector<char> tiles(static_cast<size_t>(rowCount) * columnCount);
+    for (int row = 0; row < rowCount; ++row) readRow(row, 0, columnCount, tiles.data() + static_cast<size_t>(row) * columnCount);
+    return tiles;
+}
+
+size_t TileMap::storedChunks() const {
+    return static_cast<size_t>(std::count_if(chunks.begin(), chunks.end(), [](const auto& chunk) { return chunk != nullptr; }));
+}
@@ -0,0 +1,72 @@
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Tiles of a level, stored in chunkSize x chunkSize chunks. Copies share their
+// chunks and a chunk is only copied when one of its sharers writes to it, so a copy
+// is a cheap snapshot that other threads can read while editing goes on. A missing
+// chunk is all air, which keeps large mostly empty levels small.
+class TileMap
+{
+public:
+    static constexpr int chunkShift = 6;
+    static constexpr int chunkSize = 1 << chunkShift;
+    static constexpr char air = '-';
+
+    TileMap() = default;
+    TileMap(int rows, int columns, char tile = air);
+    // From rows * columns tiles in row-major order.
+    TileMap(int rows, int columns, const std::vector<char>& data);
+
+    int rows() const { return rowCount; }
+    int columns() const { return columnCount; }
+    bool isEmpty() const { return rowCount == 0 || columnCount == 0; }
+    bool contains(int row, int col) const { return row >= 0 && col >= 0 && row < rowCount && col < columnCount; }
+
+    char at(int row, int col) const {
+        const Chunk* chunk = chunks[chunkIndex(row, col)].get();
+        return chunk ? (*chunk)[cellIndex(row, col)] : air;
+    }
+    void set(int row, int col, char tile);
+    void setIndex(size_t index, char tile) { set(static_cast<int>(index / columnCount), static_cast<int>(index % columnCount), tile); }
+
+    // Row spans; callers keep col..col+count-1 inside the map.
+    void readRow(int row, int col, int count, char* out) const;
+    void writeRow(int row, int col, int count, const char* tiles);
+    void fillRow(int row, int col, int count, char tile);
+
+    // Copy of rows x columns tiles from (row, col); cells outside the map read as air.
+    TileMap region(int row, int col, int rows, int columns) const;
+    // Blits tiles row by row with their first cell at (row, col), clipped to the map.
+    void paste(const TileMap& tiles, int row, int col);
+
+    void fill(char tile);
+    // Keeps the overlapping tiles; new cells are air.
+    void resize(int rows, int columns);
+
+    std::vector<char> toVector() const;
+    // Chunks that hold tiles, the rest being implicit air.
+    size_t storedChunks() const;
+    // Bytes held by the chunks and the chunk table; shared chunks are counted in full.
+    size_t memoryUsage() const { return storedChunks() * sizeof(Chunk) + chunks.capacity() * sizeof(chunks[0]); }
+
+private:
+    using Chunk = std::array<char, chunkSize * chunkSize>;
+
+    size_t chunkIndex(int row, int col) const {
+        return static_cast<size_t>(row >> chunkShift) * chunkColumns + (col >> chunkShift);
+    }
+    static int cellIndex(int row, int col) { return (row & (chunkSize - 1)) * chunkSize + (col & (chunkSize - 1)); }
+    Chunk& writableChunk(size_t index);
+
+    int rowCount = 0;
+    int columnCount = 0;
+    int chunkColumns = 0;
+    std::vector<std::shared_ptr<Chunk>> chunks;
+};
+
+#endif // TILEMAP_H
@@ -0,0 +1,72 @@
+#include "TileMipmap.h"
+
+#include <algorithm>
+
+void TileMipmap::build(const TileMap& map) {
+    levels.clear();
+    valid = true;
+    if (map.isEmpty()) return;
+
+    QImage base(map.columns(), map.rows(), QImage::Format_RGB32);
+    std::vector<char> tiles(static_cast<size_t>(map.columns()));
+    for (int row = 0; row < map.rows(); ++row) {
+        map.readRow(row, 0, map.columns(), tiles.data());
+        auto* line = reinterpret_cast<QRgb*>(base.scanLine(row));
+        for (int col = 0; col < map.columns(); ++col) line[col] = colors[static_cast<unsigned char>(tiles[col])];
+    }
+    levels.push_back(std::move(base));
+
+    while (levels.back().width() > 1 || levels.back().height() > 1) {
+        const QSize size((levels.back().width() + 1) / 2, (levels.back().height() + 1) / 2);
+        levels.emplace_back(size, QImage::Format_RGB32);
+        const int index = levelCount() - 1;
+        for (int row = 0; row < levels[index].height(); ++row) {
+            for (int col = 0; col < levels[index].width(); ++col) reduce(index, row, col);
+        }
+    }
+}
+
+void TileMipmap::update(const TileMap& map, int row, int col) {
+    if (!valid || levels.empty() || !map.contains(row, col)) return;
+    levels[0].setPixel(col, row, colors[static_cast<unsigned char>(map.at(row, col))]);
+    for (int index = 1; index < levelCount(); ++index) {
+        row /= 2;
+        col /= 2;
+        reduce(index, row, col);
+    }
+}
+
+void TileMipmap::update(const TileMap& map, const QRect& cells) {
+    if (!valid || levels.empty()) return;
+    QRect area = cells.intersected(QRect(0, 0, map.columns(), map.rows()));
+    if (area.isEmpty()) return;
+    std::vector<char> tiles(static_cast<size_t>(area.width()));
+    for (int row = area.top(); row <= area.bottom(); ++row) {
+        map.readRow(row, area.left(), area.width(), tiles.data());
+        auto* line = reinterpret_cast<QRgb*>(levels[0].scanLine(row)) + area.left();
+        for (int i = 0; i < area.width(); ++i) line[i] = colors[static_cast<unsigned char>(tiles[i])];
+    }
+    for (int index = 1; index < levelCount(); ++index) {
+        area = QRect(QPoint(area.left() / 2, area.top() / 2), QPoint(area.right() / 2, area.bottom() / 2));
+        for (int row = area.top(); row <= area.bottom(); ++row) {
+            for (int col = area.left(); col <= area.right(); ++col) reduce(index, row, col);
+        }
+    }
+}
+
+// Recomputes one pixel of levels[index] from the up to four pixels below it.
+void TileMipmap::reduce(int index, int row, int col) {
+    const QImage& source = levels[index - 1];
+    int red = 0, green = 0, blue = 0, count = 0;
+    for (int y = row * 2; y < std::min(row * 2 + 2, source.height()); ++y) {
+        const auto* line = reinterpret_cast<const QRgb*>(source.constScanLine(y));
+        for (int x = col * 2; x < std::min(col * 2 + 2, source.width()); ++x) {
+            red += qRed(line[x]);
+            green += qGreen(line[x]);
+            blue += qBlue(line[x]);
+            ++count;
+        }
+    }
+    auto* target = reinterpret_cast<QRgb*>(levels[index].scanLine(row));
+    target[col] = qRgb(red / count, green / count, blue / count);
+}
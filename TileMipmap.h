@@ -0,0 +1,50 @@
+#ifndef TILEMIPMAP_H
+#define TILEMIPMAP_H
+
+#include <QImage>
+#include <QRect>
+#include <array>
+#include <vector>
+#include "TileMap.h"
+
+// Color pyramid of a tile map: level 0 has one pixel per tile, every further level
+// halves both sides by averaging 2x2 blocks, down to a single pixel. Zoomed-out
+// views draw the level whose pixels are closest to one screen pixel, so their cost
+// depends on the view size rather than the level size. Edits update only the pixels
+// above the changed cells: one per level for a single tile, the halved rectangle per
+// level for a stroke or paste. Replacing the whole map (a new level, a fill)
+// invalidates the pyramid and it is rebuilt on use.
+class TileMipmap
+{
+public:
+    explicit TileMipmap(const std::array<QRgb, 256>& colors) : colors(colors) {}
+
+    bool isValid() const { return valid; }
+    void invalidate() { valid = false; }
+    void build(const TileMap& map);
+    void update(const TileMap& map, int row, int col);
+    void update(const TileMap& map, const QRect& cells);
+
+    int levelCount() const { return static_cast<int>(levels.size()); }
+    const QImage& level(int index) const { return levels[index]; }
+    size_t memoryUsage() const {
+        size_t bytes = 0;
+        for (const QImage& image : levels) bytes += static_cast<size_t>(image.sizeInBytes());
+        return bytes;
+    }
+    // The coarsest level whose blocks still cover at least a pixel at zoom pixels per tile.
+    int levelFor(qreal zoom) const {
+        int index = 0;
+        while (index + 1 < levelCount() && (1 << index) * zoom < 1) ++index;
+        return index;
+    }
+
+private:
+    void reduce(int index, int row, int col);
+
+    const std::array<QRgb, 256>& colors;
+    std::vector<QImage> levels;
+    bool valid = false;
+};
+
+#endif // TILEMIPMAP_H
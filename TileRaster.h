@@ -0,0 +1,73 @@
+#ifndef TILERASTER_H
+#define TILERASTER_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+#include "TileMap.h"
+
+// Calls visit(row, col) for every cell on the line between two cells, ends included,
+// with no gaps between consecutive cells (Bresenham).
+template <typename Visit>
+void forEachCellOnLine(int row0, int col0, int row1, int col1, Visit&& visit) {
+    const int dx = std::abs(col1 - col0);
+    const int dy = -std::abs(row1 - row0);
+    const int stepX = col0 < col1 ? 1 : -1;
+    const int stepY = row0 < row1 ? 1 : -1;
+    int error = dx + dy;
+    for (;;) {
+        visit(row0, col0);
+        if (row0 == row1 && col0 == col1) return;
+        const int twice = 2 * error;
+        if (twice >= dy) {
+            error += dy;
+            col0 += stepX;
+        }
+        if (twice <= dx) {
+            error += dx;
+            row0 += stepY;
+        }
+    }
+}
+
+// Scanline flood fill of the region of equal tiles around (row, col). Each span is
+// reported to visit(row, firstCol, lastCol) before it is overwritten with tile.
+// With eightConnected, diagonal neighbours belong to the region as well.
+template <typename Visit>
+void floodFill(TileMap& map, int row, int col, char tile, bool eightConnected, Visit&& visit) {
+    if (!map.contains(row, col)) return;
+    const char target = map.at(row, col);
+    if (target == tile) return;
+
+    const int reach = eightConnected ? 1 : 0;
+    std::vector<char> neighbour(static_cast<size_t>(map.columns()));
+    std::vector<std::pair<int, int>> seeds{{row, col}};
+    while (!seeds.empty()) {
+        const auto [seedRow, seedCol] = seeds.back();
+        seeds.pop_back();
+        if (map.at(seedRow, seedCol) != target) continue;
+
+        int first = seedCol;
+        int last = seedCol;
+        while (first > 0 && map.at(seedRow, first - 1) == target) --first;
+        while (last + 1 < map.columns() && map.at(seedRow, last + 1) == target) ++last;
+        visit(seedRow, first, last);
+        map.fillRow(seedRow, first, last - first + 1, tile);
+
+        // One seed per run of target tiles in the rows above and below the span.
+        const int from = std::max(first - reach, 0);
+        const int to = std::min(last + reach, map.columns() - 1);
+        for (const int next : {seedRow - 1, seedRow + 1}) {
+            if (next < 0 || next >= map.rows()) continue;
+            map.readRow(next, from, to - from + 1, neighbour.data() + from);
+            for (int x = from; x <= to; ++x) {
+                if (neighbour[x] != target) continue;
+                seeds.emplace_back(next, x);
+                while (x <= to && neighbour[x] == target) ++x;
+            }
+        }
+    }
+}
+
+#endif // TILERASTER_H
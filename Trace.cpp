@@ -0,0 +1,118 @@
+#include "Trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace trace {
+
+namespace {
+
+// Keeps a forgotten recording from eating all memory: about 24MB per thread.
+constexpr size_t maxEventsPerThread = size_t(1) << 20;
+
+struct Event {
+    const char* name;
+    int64_t start;
+    int64_t end;
+};
+
+struct ThreadBuffer {
+    std::mutex lock;
+    std::vector<Event> events;
+    unsigned id = 0;
+    size_t dropped = 0;
+};
+
+std::atomic<bool> recording{false};
+std::mutex registryLock;
+std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+ThreadBuffer& localBuffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+        auto created = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> guard(registryLock);
+        created->id = static_cast<unsigned>(buffers.size()) + 1;
+        buffers.push_back(created);
+        return created;
+    }();
+    return *buffer;
+}
+
+void appendEscaped(std::string& out, const char* text) {
+    for (; *text; ++text) {
+        const char c = *text;
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) out += c;
+    }
+}
+
+} // namespace
+
+bool enabled() {
+    return recording.load(std::memory_order_relaxed);
+}
+
+void setEnabled(bool enabled) {
+    recording.store(enabled, std::memory_order_relaxed);
+}
+
+int64_t now() {
+    static const auto origin = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void record(const char* name, int64_t start, int64_t end) {
+    ThreadBuffer& buffer = localBuffer();
+    std::lock_guard<std::mutex> guard(buffer.lock);
+    if (buffer.events.size() >= maxEventsPerThread) {
+        ++buffer.dropped;
+        return;
+    }
+    buffer.events.push_back({name, start, end});
+}
+
+void clear() {
+    std::lock_guard<std::mutex> guard(registryLock);
+    for (const auto& buffer : buffers) {
+        std::lock_guard<std::mutex> bufferGuard(buffer->lock);
+        buffer->events.clear();
+        buffer->dropped = 0;
+    }
+}
+
+bool writeChromeJson(const std::string& path) {
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> guard(registryLock);
+        for (const auto& buffer : buffers) {
+            std::lock_guard<std::mutex> bufferGuard(buffer->lock);
+            for (const Event& event : buffer->events) {
+                json += first ? "\n" : ",\n";
+                first = false;
+                json += "{\"name\":\"";
+                appendEscaped(json, event.name);
+                // Complete events, with times in microseconds.
+                json += "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(buffer->id)
+                      + ",\"ts\":" + std::to_string(event.start / 1000.0)
+                      + ",\"dur\":" + std::to_string((event.end - event.start) / 1000.0) + "}";
+            }
+            if (buffer->dropped > 0) {
+                json += first ? "\n" : ",\n";
+                first = false;
+                json += "{\"name\":\"dropped " + std::to_string(buffer->dropped) + " events\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":"
+                      + std::to_string(buffer->id) + ",\"ts\":0}";
+            }
+        }
+    }
+    json += "\n]}\n";
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output << json;
+    return static_cast<bool>(output.flush());
+}
+
+} // namespace trace
@@ -0,0 +1,47 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <string>
+
+// Scoped timing of hot paths, exported as Chrome trace-event JSON (open it in
+// chrome://tracing or Perfetto). TRACE_SCOPE compiles to nothing unless the build
+// defines LEVEL_EDITOR_TRACING; when compiled in, scopes cost one relaxed load
+// until recording is enabled. Each thread appends to its own buffer.
+namespace trace {
+
+bool enabled();
+void setEnabled(bool enabled);
+// Nanoseconds since the first call, on a steady clock.
+int64_t now();
+void record(const char* name, int64_t start, int64_t end);
+void clear();
+bool writeChromeJson(const std::string& path);
+
+class Scope
+{
+public:
+    explicit Scope(const char* name) : name(name), start(enabled() ? now() : -1) {}
+    ~Scope() {
+        if (start >= 0) record(name, start, now());
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* name;
+    int64_t start;
+};
+
+} // namespace trace
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#if LEVEL_EDITOR_TRACING
+#define TRACE_SCOPE(name) const trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name) static_cast<void>(0)
+#endif
+
+#endif // TRACE_H
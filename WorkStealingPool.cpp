@@ -0,0 +1,89 @@
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+
+namespace {
+
+thread_local const WorkStealingPool* currentPool = nullptr;
+thread_local unsigned currentWorker = 0;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(unsigned threadCount) {
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    queues.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) queues.push_back(std::make_unique<Queue>());
+    threads.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) threads.emplace_back([this, i] { run(i); });
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> locker(idleLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) thread.join();
+}
+
+void WorkStealingPool::submit(Task task) {
+    const unsigned target = currentPool == this ? currentWorker : nextQueue.fetch_add(1) % size();
+    pending.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> locker(queues[target]->lock);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    queued.fetch_add(1);
+    // Taking the lock orders this against a worker that checked queued and is about to sleep.
+    { std::lock_guard<std::mutex> locker(idleLock); }
+    wake.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> locker(idleLock);
+    finished.wait(locker, [this] { return pending.load() == 0; });
+}
+
+bool WorkStealingPool::take(unsigned self, Task& task) {
+    {
+        Queue& own = *queues[self];
+        std::lock_guard<std::mutex> locker(own.lock);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (unsigned i = 1; i < size(); ++i) {
+        Queue& victim = *queues[(self + i) % size()];
+        std::lock_guard<std::mutex> locker(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::run(unsigned self) {
+    currentPool = this;
+    currentWorker = self;
+    Task task;
+    for (;;) {
+        if (take(self, task)) {
+            queued.fetch_sub(1);
+            task();
+            task = nullptr;
+            if (pending.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> locker(idleLock);
+                finished.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> locker(idleLock);
+        wake.wait(locker, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) return;
+    }
+}
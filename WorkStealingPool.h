@@ -0,0 +1,52 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread pool with one deque per worker. A worker runs its own newest task first
+// and steals the oldest task of another worker when it runs dry, so a task that
+// splits itself (a big pack into level ranges) keeps its pieces local until
+// someone is idle. Tasks submitted from outside the pool are spread round-robin.
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingPool(unsigned threadCount = 0);
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(queues.size()); }
+    void submit(Task task);
+    // Blocks until every submitted task, including ones submitted by tasks, has finished.
+    void wait();
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    bool take(unsigned self, Task& task);
+    void run(unsigned self);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex idleLock;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    std::atomic<long> queued{0};
+    std::atomic<size_t> pending{0};
+    std::atomic<unsigned> nextQueue{0};
+    bool stopping = false;
+};
+
+#endif // WORKSTEALINGPOOL_H
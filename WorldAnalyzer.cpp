@@ -0,0 +1,90 @@
+#include "WorldAnalyzer.h"
+
+#include "Trace.h"
+#include "WorkStealingPool.h"
+
+namespace {
+
+constexpr int levelsPerTask = 16;
+
+} // namespace
+
+WorldAnalyzer::WorldAnalyzer()
+    : nodes(std::make_shared<std::vector<world::LevelNode>>()), latest(std::make_shared<std::atomic<quint64>>(0)),
+      latestReset(std::make_shared<std::atomic<quint64>>(0))
+{
+    worker.setMaxThreadCount(1);
+}
+
+WorldAnalyzer::~WorldAnalyzer() {
+    latest->store(~quint64(0));
+    latestReset->store(~quint64(0));
+    worker.clear();
+    worker.waitForDone();
+}
+
+void WorldAnalyzer::setResultHandler(QObject* context, ResultHandler handler) {
+    resultContext = context;
+    resultHandler = std::move(handler);
+}
+
+void WorldAnalyzer::reset(const LevelPack& pack) {
+    levelCount = pack.count();
+    const quint64 job = ++generation;
+    latest->store(job);
+    latestReset->store(job);
+
+    // Queued jobs only refine the nodes this job rebuilds from scratch.
+    worker.clear();
+    worker.start([this, nodes = nodes, latest = latest, latestReset = latestReset, snapshot = pack.snapshot(), job]() mutable {
+        TRACE_SCOPE("WorldAnalyzer::reset");
+        const int count = snapshot->count();
+        nodes->assign(static_cast<size_t>(count), world::LevelNode());
+        {
+            WorkStealingPool pool;
+            for (int first = 0; first < count; first += levelsPerTask) {
+                pool.submit([&, first] {
+                    if (latestReset->load() != job) return;
+                    rle::Level scratch;
+                    std::string text;
+                    const int last = std::min(count, first + levelsPerTask);
+                    for (int i = first; i < last; ++i)
+                        (*nodes)[i] = world::inspectLevel(snapshot->number(i), snapshot->encoded(i, text), scratch);
+                });
+            }
+        }
+        snapshot.reset();
+        if (latest->load() != job) return;
+        post(*nodes, world::analyze(*nodes), job);
+    });
+}
+
+void WorldAnalyzer::levelChanged(const LevelPack& pack, int index) {
+    if (pack.count() != levelCount) {
+        reset(pack);
+        return;
+    }
+    const quint64 job = ++generation;
+    latest->store(job);
+    worker.start([this, nodes = nodes, latest = latest, encoded = pack.encoded(index), number = pack.number(index), index, job] {
+        rle::Level scratch;
+        (*nodes)[index] = world::inspectLevel(number, std::string_view(encoded.constData(), encoded.size()), scratch);
+        if (latest->load() != job) return;
+        post(*nodes, world::analyze(*nodes), job);
+    });
+}
+
+void WorldAnalyzer::cancel() {
+    latest->store(++generation);
+    latestReset->store(generation);
+    worker.clear();
+    // The nodes may be half rebuilt, so the next change starts over.
+    levelCount = -1;
+}
+
+void WorldAnalyzer::post(std::vector<world::LevelNode> result, world::Report report, quint64 job) {
+    if (!resultContext || !resultHandler) return;
+    QMetaObject::invokeMethod(resultContext.data(), [this, result = std::move(result), report = std::move(report), job] {
+        if (job == generation) resultHandler(result, report);
+    }, Qt::QueuedConnection);
+}
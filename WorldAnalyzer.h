@@ -0,0 +1,51 @@
+#ifndef WORLDANALYZER_H
+#define WORLDANALYZER_H
+
+#include <QByteArray>
+#include <QPointer>
+#include <QThreadPool>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "LevelPack.h"
+#include "WorldGraph.h"
+
+// Keeps a world::Report for a level pack up to date off the GUI thread. The GUI
+// thread only takes a LevelPack::Snapshot; reading and decoding the levels runs in
+// parallel on a work-stealing pool and the graph is analyzed on a single background
+// thread, so jobs apply in submission order. Saving one level re-inspects just that
+// level.
+class WorldAnalyzer
+{
+public:
+    using ResultHandler = std::function<void(const std::vector<world::LevelNode>&, const world::Report&)>;
+
+    WorldAnalyzer();
+    ~WorldAnalyzer();
+    WorldAnalyzer(const WorldAnalyzer&) = delete;
+    WorldAnalyzer& operator=(const WorldAnalyzer&) = delete;
+
+    // The handler runs on context's thread with the newest result.
+    void setResultHandler(QObject* context, ResultHandler handler);
+    void reset(const LevelPack& pack);
+    void levelChanged(const LevelPack& pack, int index);
+    // Drops queued jobs and stops the running one, releasing its snapshot.
+    void cancel();
+
+private:
+    void post(std::vector<world::LevelNode> nodes, world::Report report, quint64 generation);
+
+    // Only touched by jobs on worker, which runs one job at a time.
+    std::shared_ptr<std::vector<world::LevelNode>> nodes;
+    int levelCount = 0;
+    quint64 generation = 0;
+    std::shared_ptr<std::atomic<quint64>> latest;
+    // The job of the latest reset or cancel; only those stop a reset half way.
+    std::shared_ptr<std::atomic<quint64>> latestReset;
+    QThreadPool worker;
+    QPointer<QObject> resultContext;
+    ResultHandler resultHandler;
+};
+
+#endif // WORLDANALYZER_H
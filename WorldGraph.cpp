@@ -0,0 +1,147 @@
+#include "WorldGraph.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+
+namespace world {
+
+const char* directionName(int direction) {
+    switch (direction) {
+        case Left:  return "left";
+        case Right: return "right";
+        case Up:    return "up";
+        case Down:  return "down";
+    }
+    return "?";
+}
+
+LevelNode inspectLevel(int number, std::string_view encoded, rle::Level& scratch) {
+    LevelNode node;
+    node.number = number;
+    node.error = rle::decode(encoded, scratch);
+    if (node.error) return node;
+    std::copy(scratch.nextLevel, scratch.nextLevel + 4, node.next);
+    const char* tiles = scratch.tiles.data();
+    for (int d = 0; d < 4; ++d) node.hasSpawn[d] = std::memchr(tiles, spawnTiles[d], scratch.tiles.size()) != nullptr;
+    return node;
+}
+
+std::string describe(const Issue& issue, const LevelNode* node) {
+    const std::string level = "Level " + std::to_string(issue.level);
+    const std::string link = issue.direction >= 0 ? std::string(directionName(issue.direction)) + " link" : "link";
+    switch (issue.kind) {
+        case Issue::Kind::InvalidLevel:
+            return level + " cannot be decoded" + (node ? ": " + rle::describe(node->error) : std::string());
+        case Issue::Kind::DuplicateNumber:
+            return level + " appears more than once";
+        case Issue::Kind::DanglingLink:
+            return level + ": " + link + " to missing level " + std::to_string(issue.target);
+        case Issue::Kind::MissingSpawn:
+            return level + ": " + link + " to level " + std::to_string(issue.target) + ", which has no '"
+                 + spawnTiles[issue.direction] + "' spawn tile";
+        case Issue::Kind::Unreachable:
+            return level + " cannot be reached from level " + std::to_string(issue.target);
+        case Issue::Kind::NoPathToWin:
+            return level + " is reachable but has no path to a win";
+    }
+    return level;
+}
+
+Report analyze(const std::vector<LevelNode>& levels) {
+    Report report;
+    if (levels.empty()) return report;
+
+    std::unordered_map<int, size_t> byNumber;
+    byNumber.reserve(levels.size());
+    for (size_t i = 0; i < levels.size(); ++i) {
+        if (!byNumber.emplace(levels[i].number, i).second)
+            report.issues.push_back({Issue::Kind::DuplicateNumber, levels[i].number});
+    }
+    report.start = byNumber.count(1) ? 1 : std::min_element(levels.begin(), levels.end(), [](const auto& a, const auto& b) {
+        return a.number < b.number;
+    })->number;
+
+    // Usable edges only: the target exists and has the spawn tile the link arrives at.
+    constexpr size_t none = size_t(-1);
+    std::vector<std::array<size_t, 4>> edges(levels.size());
+    std::vector<std::vector<size_t>> incoming(levels.size());
+    for (size_t i = 0; i < levels.size(); ++i) {
+        const LevelNode& node = levels[i];
+        edges[i].fill(none);
+        if (node.error) {
+            report.issues.push_back({Issue::Kind::InvalidLevel, node.number});
+            continue;
+        }
+        for (int d = 0; d < 4; ++d) {
+            const int target = node.next[d];
+            if (target <= 0) continue;
+            const auto found = byNumber.find(target);
+            if (found == byNumber.end()) report.issues.push_back({Issue::Kind::DanglingLink, node.number, d, target});
+            else if (!levels[found->second].error && !levels[found->second].hasSpawn[d])
+                report.issues.push_back({Issue::Kind::MissingSpawn, node.number, d, target});
+            else if (!levels[found->second].error) {
+                edges[i][d] = found->second;
+                incoming[found->second].push_back(i);
+            }
+        }
+    }
+
+    // Forward search from the start, remembering how each level was entered for the win path.
+    const size_t start = byNumber[report.start];
+    std::vector<std::pair<size_t, int>> from(levels.size(), {none, -1});
+    std::vector<bool> reached(levels.size(), false);
+    std::deque<size_t> queue{start};
+    reached[start] = true;
+    size_t winner = none;
+    while (!queue.empty()) {
+        const size_t current = queue.front();
+        queue.pop_front();
+        const LevelNode& node = levels[current];
+        if (winner == none && !node.error && std::find(node.next, node.next + 4, win) != node.next + 4) winner = current;
+        for (int d = 0; d < 4; ++d) {
+            const size_t next = edges[current][d];
+            if (next == none || reached[next]) continue;
+            reached[next] = true;
+            from[next] = {current, d};
+            queue.push_back(next);
+        }
+    }
+    if (winner != none) {
+        const LevelNode& last = levels[winner];
+        report.winPath.push_back({last.number, int(std::find(last.next, last.next + 4, win) - last.next)});
+        for (size_t at = winner; from[at].first != none; at = from[at].first)
+            report.winPath.push_back({levels[from[at].first].number, from[at].second});
+        std::reverse(report.winPath.begin(), report.winPath.end());
+    }
+
+    // Backward search from every level with a winning exit.
+    std::vector<bool> canWin(levels.size(), false);
+    for (size_t i = 0; i < levels.size(); ++i) {
+        const LevelNode& node = levels[i];
+        if (!node.error && std::find(node.next, node.next + 4, win) != node.next + 4) {
+            canWin[i] = true;
+            queue.push_back(i);
+        }
+    }
+    while (!queue.empty()) {
+        const size_t current = queue.front();
+        queue.pop_front();
+        for (const size_t previous : incoming[current]) {
+            if (canWin[previous]) continue;
+            canWin[previous] = true;
+            queue.push_back(previous);
+        }
+    }
+
+    for (size_t i = 0; i < levels.size(); ++i) {
+        if (levels[i].error) continue;
+        if (!reached[i]) report.issues.push_back({Issue::Kind::Unreachable, levels[i].number, -1, report.start});
+        else if (!canWin[i]) report.issues.push_back({Issue::Kind::NoPathToWin, levels[i].number});
+    }
+    return report;
+}
+
+} // namespace world
@@ -0,0 +1,73 @@
+#ifndef WORLDGRAPH_H
+#define WORLDGRAPH_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "RleCodec.h"
+
+// The world formed by the next_level links of a pack. A link in direction d takes
+// the player to the target level's spawn tile for that direction, so it is only
+// usable when the target contains that tile ('L' for left, 'R', 'U', 'D').
+namespace world {
+
+enum Direction {
+    Left,
+    Right,
+    Up,
+    Down
+};
+
+constexpr int outOfBounds = 0;
+constexpr int death = -1;
+constexpr int win = -2;
+constexpr char spawnTiles[4] = {'L', 'R', 'U', 'D'};
+
+const char* directionName(int direction);
+
+struct LevelNode {
+    int number = 0;
+    int next[4] = {0, 0, 0, 0};
+    bool hasSpawn[4] = {false, false, false, false};
+    rle::Error error;
+};
+
+// Decodes one level (into scratch, to reuse its buffer) and keeps what the graph needs.
+LevelNode inspectLevel(int number, std::string_view encoded, rle::Level& scratch);
+
+struct Issue {
+    enum class Kind {
+        InvalidLevel,
+        DuplicateNumber,
+        DanglingLink,
+        MissingSpawn,
+        Unreachable,
+        NoPathToWin
+    };
+
+    Kind kind;
+    int level;
+    int direction = -1;
+    int target = 0;
+};
+
+std::string describe(const Issue& issue, const LevelNode* node = nullptr);
+
+struct Step {
+    int level;
+    int direction;
+};
+
+struct Report {
+    int start = 0;
+    // Shortest route from the start level; the last step's link leads to the win state.
+    std::vector<Step> winPath;
+    std::vector<Issue> issues;
+};
+
+// The start is level 1, or the lowest level number when there is no level 1.
+Report analyze(const std::vector<LevelNode>& levels);
+
+} // namespace world
+
+#endif // WORLDGRAPH_H
@@ -0,0 +1,74 @@
+#include "WorldPanel.h"
+
+#include <unordered_map>
+
+namespace {
+
+const char* groupTitle(world::Issue::Kind kind) {
+    switch (kind) {
+        case world::Issue::Kind::InvalidLevel:    return "Invalid levels";
+        case world::Issue::Kind::DuplicateNumber: return "Duplicate level numbers";
+        case world::Issue::Kind::DanglingLink:    return "Links to missing levels";
+        case world::Issue::Kind::MissingSpawn:    return "Links without a spawn tile";
+        case world::Issue::Kind::Unreachable:     return "Unreachable levels";
+        case world::Issue::Kind::NoPathToWin:     return "Levels with no path to a win";
+    }
+    return "Other";
+}
+
+QTreeWidgetItem* levelItem(QTreeWidgetItem* parent, const QString& text, int level) {
+    auto* item = new QTreeWidgetItem(parent, {text});
+    item->setData(0, Qt::UserRole, level);
+    return item;
+}
+
+} // namespace
+
+WorldPanel::WorldPanel(QWidget *parent)
+    : QTreeWidget(parent)
+{
+    setHeaderHidden(true);
+    setUniformRowHeights(true);
+    const auto activate = [this](QTreeWidgetItem* item) {
+        const QVariant level = item->data(0, Qt::UserRole);
+        if (level.isValid() && activated) activated(level.toInt());
+    };
+    connect(this, &QTreeWidget::itemClicked, this, activate);
+    connect(this, &QTreeWidget::itemActivated, this, activate);
+}
+
+void WorldPanel::showReport(const std::vector<world::LevelNode>& nodes, const world::Report& report) {
+    std::unordered_map<int, const world::LevelNode*> byNumber;
+    for (const world::LevelNode& node : nodes) byNumber.emplace(node.number, &node);
+
+    setUpdatesEnabled(false);
+    clear();
+    if (nodes.empty()) {
+        setUpdatesEnabled(true);
+        return;
+    }
+
+    auto* path = new QTreeWidgetItem(this);
+    if (report.winPath.empty()) path->setText(0, QString("No path to a win from level %1").arg(report.start));
+    else {
+        path->setText(0, QString("Path to win (%1 levels)").arg(report.winPath.size()));
+        for (const world::Step& step : report.winPath) {
+            const bool last = &step == &report.winPath.back();
+            levelItem(path, QString("Level %1, exit %2%3").arg(step.level).arg(world::directionName(step.direction))
+                                .arg(last ? " to win" : ""), step.level);
+        }
+    }
+
+    std::unordered_map<int, QTreeWidgetItem*> groups;
+    for (const world::Issue& issue : report.issues) {
+        QTreeWidgetItem*& group = groups[static_cast<int>(issue.kind)];
+        if (!group) group = new QTreeWidgetItem(this, {groupTitle(issue.kind)});
+        const auto node = byNumber.find(issue.level);
+        levelItem(group, QString::fromStdString(world::describe(issue, node == byNumber.end() ? nullptr : node->second)), issue.level);
+    }
+    for (const auto& [kind, group] : groups) group->setText(0, QString("%1 (%2)").arg(group->text(0)).arg(group->childCount()));
+    if (groups.empty()) new QTreeWidgetItem(this, {"No problems found"});
+
+    path->setExpanded(true);
+    setUpdatesEnabled(true);
+}
@@ -0,0 +1,23 @@
+#ifndef WORLDPANEL_H
+#define WORLDPANEL_H
+
+#include <QTreeWidget>
+#include <functional>
+#include <vector>
+#include "WorldGraph.h"
+
+// Browsable world report: the route to the win state and one group per kind of
+// problem. Activating an entry passes its level number to the activation handler.
+class WorldPanel : public QTreeWidget
+{
+public:
+    explicit WorldPanel(QWidget *parent = nullptr);
+
+    void showReport(const std::vector<world::LevelNode>& nodes, const world::Report& report);
+    void setLevelActivatedHandler(std::function<void(int)> handler) { activated = std::move(handler); }
+
+private:
+    std::function<void(int)> activated;
+};
+
+#endif // WORLDPANEL_H
@@ -1,12 +1,25 @@
 #include <QApplication>
+#include <QDebug>
 #include "MainWindow.h"
+#include "Trace.h"
 
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
 
+#if LEVEL_EDITOR_TRACING
+    // LEVEL_EDITOR_TRACE=<file.json> records a trace and writes it on exit.
+    const QString tracePath = qEnvironmentVariable("LEVEL_EDITOR_TRACE");
+    trace::setEnabled(!tracePath.isEmpty());
+#endif
+
     MainWindow window;
     window.show();
 
-    return app.exec();
+    const int result = app.exec();
+#if LEVEL_EDITOR_TRACING
+    if (!tracePath.isEmpty() && !trace::writeChromeJson(tracePath.toStdString()))
+        qWarning() << "Unable to write trace to" << tracePath;
+#endif
+    return result;
 }